@@ -3,17 +3,31 @@
 #include <zephyr/device.h>
 #include <zephyr/devicetree.h>
 #include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "wallclock.h"
+
+LOG_MODULE_REGISTER(main, LOG_LEVEL_INF);
 
 struct k_timer my_timer;
 
+/*
+ * Runs in the timer interrupt, the logging thread does the printing. The
+ * time is read from the wall clock, no conversion is needed here.
+ */
 void expiry_func(struct k_timer *timer_id)
 {
-    printk("Timer expired! at: %d\n", (k_uptime_get_32() / 1000));
+    struct wallclock_tm tm;
+
+    wallclock_get(&tm);
+    LOG_INF("Timer expired! at: %02u:%02u:%02u.%06u", tm.hours, tm.minutes,
+            tm.seconds, tm.us);
 }
 
 int main(void)
 {
     int count = 0;
+    wallclock_start(0);
     k_timer_init(&my_timer, expiry_func, NULL);
     k_timer_start(&my_timer, K_SECONDS(5), K_SECONDS(70));
     while(1)
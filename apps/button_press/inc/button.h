@@ -0,0 +1,80 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef BUTTON_H_
+#define BUTTON_H_
+
+#include <zephyr/devicetree.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef CONFIG_BUTTON_PRESS_DEBOUNCE_VCOUNT
+/* every button next to sw0 in its devicetree node, all on one GPIO port */
+#define BUTTON_COUNT DT_CHILD_NUM_STATUS_OKAY(DT_PARENT(DT_ALIAS(sw0)))
+/* a change counts once four samples in a row agree */
+#define BUTTON_DEBOUNCE_MS (4 * CONFIG_BUTTON_PRESS_VCOUNT_SAMPLE_MS)
+#else
+/* sw0 only */
+#define BUTTON_COUNT 1
+#define BUTTON_DEBOUNCE_MS CONFIG_BUTTON_PRESS_DEBOUNCE_MS
+#endif
+
+enum button_press_type {
+	/* released before CONFIG_BUTTON_PRESS_SHORT_MS, no second press followed */
+	BUTTON_PRESS_SHORT,
+	/* released before CONFIG_BUTTON_PRESS_LONG_MS */
+	BUTTON_PRESS_SINGLE,
+	BUTTON_PRESS_LONG,
+	/* two short presses less than CONFIG_BUTTON_PRESS_DOUBLE_GAP_MS apart */
+	BUTTON_PRESS_DOUBLE,
+};
+
+/* A debounced change of a button's level. */
+struct button_event {
+	/*
+	 * cycle count of the change: its first edge with the edge debouncer,
+	 * the sample that confirmed it with vertical counters
+	 */
+	uint32_t cyc;
+	/* index below BUTTON_COUNT */
+	uint8_t button;
+	bool pressed;
+};
+
+/*
+ * Called from the system workqueue for every classified press. duration_ms
+ * is how long the button was held, for a double press the second time.
+ */
+typedef void (*button_press_handler_t)(uint8_t button, enum button_press_type type,
+				       uint32_t duration_ms);
+
+/* Start the debouncer and the classifier. */
+int button_init(button_press_handler_t handler);
+
+const char *button_press_name(enum button_press_type type);
+
+/*
+ * Queue a debounced level change for classification. Called by the
+ * debouncer, safe in ISRs.
+ */
+void button_event_post(const struct button_event *evt);
+
+/*
+ * Count a wakeup of the CPU for the button: an interrupt, a timer or a
+ * work item run. The count only moves while the button is in use.
+ */
+void button_count_wakeup(void);
+uint32_t button_wakeups(void);
+
+/* Debounced events dropped because the classifier fell behind. */
+uint32_t button_events_lost(void);
+
+/*
+ * Set up the button GPIOs and their interrupts, see debounce.c and
+ * debounce_vcount.c.
+ */
+int debounce_init(void);
+
+#endif /* BUTTON_H_ */
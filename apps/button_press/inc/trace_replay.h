@@ -0,0 +1,26 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TRACE_REPLAY_H_
+#define TRACE_REPLAY_H_
+
+#include <stdint.h>
+
+#include "button.h"
+
+/*
+ * Press traces played into the emulated button GPIO, enabled with
+ * CONFIG_BUTTON_PRESS_TRACE_REPLAY. Each trace lists which buttons are
+ * down over time, bounces included, and the presses it must be classified
+ * as.
+ */
+
+/* Play every trace, check the results and measure idle wakeups. */
+void trace_replay_run(void);
+
+/* Hand a classified press to the running trace. */
+void trace_replay_record(uint8_t button, enum button_press_type type,
+			 uint32_t duration_ms);
+
+#endif /* TRACE_REPLAY_H_ */
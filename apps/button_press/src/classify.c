@@ -0,0 +1,188 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+
+#include "button.h"
+
+/*
+ * Debounced presses and releases are classified on the system workqueue,
+ * each button on its own. A short press is held back for
+ * CONFIG_BUTTON_PRESS_DOUBLE_GAP_MS in case a second one follows; every
+ * other press is reported on release. The event and timeout work items run
+ * on the same queue, so the state below needs no lock.
+ */
+
+/* room for a change of every button at once, twice */
+#define EVENT_QUEUE_LEN MAX(8, 2 * BUTTON_COUNT)
+
+K_MSGQ_DEFINE(button_msgq, sizeof(struct button_event), EVENT_QUEUE_LEN, 4);
+
+struct button_state {
+	struct k_work_delayable short_work;
+	uint8_t button;
+	/* the button is down, and since when */
+	bool held;
+	uint32_t press_cyc;
+	/* a short press waits to see whether it is the first of a double */
+	bool short_pending;
+	uint32_t short_release_cyc;
+	uint32_t short_ms;
+};
+
+static struct k_work event_work;
+static struct button_state buttons[BUTTON_COUNT];
+static button_press_handler_t press_handler;
+
+static atomic_t wakeups;
+/* events lost to a full queue */
+static atomic_t events_lost;
+
+static const char *const press_names[] = {
+	[BUTTON_PRESS_SHORT] = "short",
+	[BUTTON_PRESS_SINGLE] = "single",
+	[BUTTON_PRESS_LONG] = "long",
+	[BUTTON_PRESS_DOUBLE] = "double",
+};
+
+const char *button_press_name(enum button_press_type type)
+{
+	return press_names[type];
+}
+
+void button_count_wakeup(void)
+{
+	atomic_inc(&wakeups);
+}
+
+uint32_t button_wakeups(void)
+{
+	return (uint32_t)atomic_get(&wakeups);
+}
+
+uint32_t button_events_lost(void)
+{
+	return (uint32_t)atomic_get(&events_lost);
+}
+
+static uint32_t elapsed_ms(uint32_t from, uint32_t to)
+{
+	return k_cyc_to_ms_floor32(to - from);
+}
+
+static void flush_short(struct button_state *st)
+{
+	if (st->short_pending) {
+		st->short_pending = false;
+		press_handler(st->button, BUTTON_PRESS_SHORT, st->short_ms);
+	}
+}
+
+static void short_timeout(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct button_state *st = CONTAINER_OF(dwork, struct button_state, short_work);
+
+	button_count_wakeup();
+
+	/* no second press came in time */
+	flush_short(st);
+}
+
+static void button_pressed(struct button_state *st, const struct button_event *evt)
+{
+	st->held = true;
+	st->press_cyc = evt->cyc;
+
+	if (!st->short_pending) {
+		return;
+	}
+
+	k_work_cancel_delayable(&st->short_work);
+
+	if (elapsed_ms(st->short_release_cyc, evt->cyc) >= CONFIG_BUTTON_PRESS_DOUBLE_GAP_MS) {
+		/* the timeout was due but had not run yet */
+		flush_short(st);
+	}
+
+	/* otherwise it may be a double, the release decides */
+}
+
+static void button_released(struct button_state *st, const struct button_event *evt)
+{
+	uint32_t held_ms = elapsed_ms(st->press_cyc, evt->cyc);
+	uint32_t waited;
+
+	/* held down since boot, the press was not seen */
+	if (!st->held) {
+		return;
+	}
+	st->held = false;
+
+	if (held_ms < CONFIG_BUTTON_PRESS_SHORT_MS) {
+		if (st->short_pending) {
+			st->short_pending = false;
+			press_handler(st->button, BUTTON_PRESS_DOUBLE, held_ms);
+			return;
+		}
+
+		/* counted from the release, not from now */
+		waited = elapsed_ms(evt->cyc, k_cycle_get_32());
+		st->short_pending = true;
+		st->short_release_cyc = evt->cyc;
+		st->short_ms = held_ms;
+		k_work_schedule(&st->short_work,
+				K_MSEC(CONFIG_BUTTON_PRESS_DOUBLE_GAP_MS -
+				       MIN(waited, CONFIG_BUTTON_PRESS_DOUBLE_GAP_MS)));
+		return;
+	}
+
+	/* a short press followed closely by a longer one is two presses */
+	flush_short(st);
+
+	press_handler(st->button,
+		      held_ms < CONFIG_BUTTON_PRESS_LONG_MS ? BUTTON_PRESS_SINGLE : BUTTON_PRESS_LONG,
+		      held_ms);
+}
+
+static void event_drain(struct k_work *work)
+{
+	struct button_event evt;
+
+	button_count_wakeup();
+
+	while (k_msgq_get(&button_msgq, &evt, K_NO_WAIT) == 0) {
+		struct button_state *st = &buttons[evt.button];
+
+		if (evt.pressed) {
+			button_pressed(st, &evt);
+		} else {
+			button_released(st, &evt);
+		}
+	}
+}
+
+void button_event_post(const struct button_event *evt)
+{
+	if (k_msgq_put(&button_msgq, evt, K_NO_WAIT) < 0) {
+		atomic_inc(&events_lost);
+		return;
+	}
+
+	k_work_submit(&event_work);
+}
+
+int button_init(button_press_handler_t handler)
+{
+	press_handler = handler;
+	k_work_init(&event_work, event_drain);
+
+	for (int i = 0; i < BUTTON_COUNT; i++) {
+		buttons[i].button = i;
+		k_work_init_delayable(&buttons[i].short_work, short_timeout);
+	}
+
+	return debounce_init();
+}
@@ -0,0 +1,103 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/gpio.h>
+
+#include "button.h"
+
+/*
+ * Edge-triggered debouncer for the sw0 button. Nothing runs while the button is left alone:
+ * every edge interrupt (re)starts a one-shot settle timer, and once the
+ * level has been quiet for CONFIG_BUTTON_PRESS_DEBOUNCE_MS the timer reads
+ * it. A level that differs from the last debounced one is a press or a
+ * release, stamped with the cycle count of the first edge of its burst.
+ * Pulses shorter than the settle time leave the level unchanged and are
+ * dropped.
+ */
+
+static const struct gpio_dt_spec button = GPIO_DT_SPEC_GET(DT_ALIAS(sw0), gpios);
+static struct gpio_callback button_cb;
+static struct k_timer settle_timer;
+
+static struct k_spinlock lock;
+/* debounced level, only changed by settle_expiry() */
+static bool stable;
+/* an edge came since the level was last stable, and when the first did */
+static bool settling;
+static uint32_t first_edge;
+
+static void button_edge(const struct device *dev, struct gpio_callback *cb,
+			uint32_t pins)
+{
+	uint32_t now = k_cycle_get_32();
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	button_count_wakeup();
+
+	if (!settling) {
+		settling = true;
+		first_edge = now;
+	}
+
+	/* the level has to stay put for a whole settle time after the last edge */
+	k_timer_start(&settle_timer, K_MSEC(CONFIG_BUTTON_PRESS_DEBOUNCE_MS), K_NO_WAIT);
+	k_spin_unlock(&lock, key);
+}
+
+static void settle_expiry(struct k_timer *timer_id)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	struct button_event evt = {
+		.cyc = first_edge,
+		.button = 0,
+		.pressed = gpio_pin_get_dt(&button) > 0,
+	};
+
+	button_count_wakeup();
+	settling = false;
+
+	if (evt.pressed == stable) {
+		/* bounced back, a glitch */
+		k_spin_unlock(&lock, key);
+		return;
+	}
+
+	stable = evt.pressed;
+	k_spin_unlock(&lock, key);
+
+	button_event_post(&evt);
+}
+
+int debounce_init(void)
+{
+	int ret;
+
+	if (!gpio_is_ready_dt(&button)) {
+		printk("Button device %s is not ready\n", button.port->name);
+		return -ENODEV;
+	}
+
+	ret = gpio_pin_configure_dt(&button, GPIO_INPUT);
+	if (ret < 0) {
+		printk("Failed to configure the button pin: %d\n", ret);
+		return ret;
+	}
+
+	k_timer_init(&settle_timer, settle_expiry, NULL);
+	stable = gpio_pin_get_dt(&button) > 0;
+
+	gpio_init_callback(&button_cb, button_edge, BIT(button.pin));
+	gpio_add_callback(button.port, &button_cb);
+
+	ret = gpio_pin_interrupt_configure_dt(&button, GPIO_INT_EDGE_BOTH);
+	if (ret < 0) {
+		printk("Failed to enable the button interrupt: %d\n", ret);
+		return ret;
+	}
+
+	return 0;
+}
@@ -0,0 +1,166 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/gpio.h>
+
+#include "button.h"
+
+/*
+ * Port-wide debouncer with vertical counters. Every button pin gets a 2-bit
+ * counter whose two bits live in ct1 and ct0, one bit position per pin, so
+ * one sample of the whole port is debounced with a handful of bitwise
+ * operations however many buttons there are. A pin's counter runs while
+ * its sample differs from its debounced level and restarts as soon as they
+ * agree; after four differing samples in a row the debounced level flips.
+ *
+ * Sampling only runs while a pin is settling: any edge interrupt starts
+ * the sample timer, and it stops once every pin matches its debounced
+ * level, so an idle panel costs nothing.
+ */
+
+#define BUTTONS_NODE DT_PARENT(DT_ALIAS(sw0))
+#define BUTTON_SPEC(_node) GPIO_DT_SPEC_GET(_node, gpios),
+
+static const struct gpio_dt_spec specs[] = {
+	DT_FOREACH_CHILD_STATUS_OKAY(BUTTONS_NODE, BUTTON_SPEC)
+};
+
+BUILD_ASSERT(ARRAY_SIZE(specs) == BUTTON_COUNT, "one spec per button");
+
+static const struct device *port;
+static gpio_port_pins_t pin_mask;
+/* pins whose raw level is low when pressed */
+static gpio_port_pins_t active_low;
+static uint8_t pin_button[32];
+
+static struct gpio_callback button_cb;
+static struct k_timer sample_timer;
+
+static struct k_spinlock lock;
+/* debounced levels, one bit per pin, 1 for pressed */
+static gpio_port_value_t state;
+/* vertical counters, both bits set while a pin agrees with state */
+static gpio_port_value_t ct0;
+static gpio_port_value_t ct1;
+static bool sampling;
+
+static void sample_expiry(struct k_timer *timer_id)
+{
+	uint32_t now = k_cycle_get_32();
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	gpio_port_value_t raw = 0;
+	gpio_port_value_t sample;
+	gpio_port_value_t delta;
+	gpio_port_value_t toggled;
+	gpio_port_value_t pressed;
+
+	button_count_wakeup();
+
+	gpio_port_get_raw(port, &raw);
+	sample = (raw ^ active_low) & pin_mask;
+
+	/* count down where the sample differs, reset where it agrees */
+	delta = state ^ sample;
+	ct0 = ~(ct0 & delta);
+	ct1 = ct0 ^ (ct1 & delta);
+	/* counted through four samples */
+	toggled = delta & ct0 & ct1;
+	state ^= toggled;
+	pressed = state;
+
+	if (state == sample) {
+		/* everything settled, the next edge starts sampling again */
+		sampling = false;
+		k_timer_stop(&sample_timer);
+	}
+
+	k_spin_unlock(&lock, key);
+
+	while (toggled != 0) {
+		uint32_t pin = find_lsb_set(toggled) - 1;
+		struct button_event evt = {
+			.cyc = now,
+			.button = pin_button[pin],
+			.pressed = (pressed & BIT(pin)) != 0,
+		};
+
+		toggled &= toggled - 1;
+		button_event_post(&evt);
+	}
+}
+
+static void button_edge(const struct device *dev, struct gpio_callback *cb,
+			uint32_t pins)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	button_count_wakeup();
+
+	if (!sampling) {
+		sampling = true;
+		k_timer_start(&sample_timer, K_MSEC(CONFIG_BUTTON_PRESS_VCOUNT_SAMPLE_MS),
+			      K_MSEC(CONFIG_BUTTON_PRESS_VCOUNT_SAMPLE_MS));
+	}
+
+	k_spin_unlock(&lock, key);
+}
+
+int debounce_init(void)
+{
+	gpio_port_value_t raw = 0;
+	int ret;
+
+	port = specs[0].port;
+
+	if (!device_is_ready(port)) {
+		printk("Button device %s is not ready\n", port->name);
+		return -ENODEV;
+	}
+
+	for (int i = 0; i < ARRAY_SIZE(specs); i++) {
+		if (specs[i].port != port) {
+			printk("Button %d is not on %s, all buttons must share a port\n", i,
+			       port->name);
+			return -EINVAL;
+		}
+
+		ret = gpio_pin_configure_dt(&specs[i], GPIO_INPUT);
+		if (ret < 0) {
+			printk("Failed to configure button %d: %d\n", i, ret);
+			return ret;
+		}
+
+		pin_mask |= BIT(specs[i].pin);
+		if (specs[i].dt_flags & GPIO_ACTIVE_LOW) {
+			active_low |= BIT(specs[i].pin);
+		}
+		pin_button[specs[i].pin] = i;
+	}
+
+	k_timer_init(&sample_timer, sample_expiry, NULL);
+
+	/* buttons held at boot start out pressed, their first release is ignored */
+	gpio_port_get_raw(port, &raw);
+	state = (raw ^ active_low) & pin_mask;
+	ct0 = ~0U;
+	ct1 = ~0U;
+
+	gpio_init_callback(&button_cb, button_edge, pin_mask);
+	gpio_add_callback(port, &button_cb);
+
+	for (int i = 0; i < ARRAY_SIZE(specs); i++) {
+		ret = gpio_pin_interrupt_configure_dt(&specs[i], GPIO_INT_EDGE_BOTH);
+		if (ret < 0) {
+			printk("Failed to enable the interrupt of button %d: %d\n", i, ret);
+			return ret;
+		}
+	}
+
+	printk("Debouncing %d buttons on %s every %d ms\n", BUTTON_COUNT, port->name,
+	       CONFIG_BUTTON_PRESS_VCOUNT_SAMPLE_MS);
+	return 0;
+}
@@ -0,0 +1,32 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+
+#include "button.h"
+#include "trace_replay.h"
+
+static void on_press(uint8_t button, enum button_press_type type, uint32_t duration_ms)
+{
+	printk("button %u: %s press, held %u ms\n", button, button_press_name(type),
+	       duration_ms);
+
+#ifdef CONFIG_BUTTON_PRESS_TRACE_REPLAY
+	trace_replay_record(button, type, duration_ms);
+#endif
+}
+
+int main(void)
+{
+	if (button_init(on_press) < 0) {
+		return 0;
+	}
+
+#ifdef CONFIG_BUTTON_PRESS_TRACE_REPLAY
+	trace_replay_run();
+#else
+	printk("Press the button\n");
+#endif
+	return 0;
+}
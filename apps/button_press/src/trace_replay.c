@@ -0,0 +1,202 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+
+#include "button.h"
+#include "trace_replay.h"
+
+/* longest list of expected presses in a trace */
+#define EXPECT_MAX 4
+
+/* idle time over which wakeups are counted */
+#define IDLE_MS 2000
+/* interval of the polling design this app replaces */
+#define POLL_MS 5
+
+/* the buttons in pressed, one bit each, are held down for ms */
+struct trace_step {
+	uint8_t pressed;
+	uint16_t ms;
+};
+
+struct trace_press {
+	uint8_t button;
+	enum button_press_type type;
+};
+
+struct trace {
+	const char *name;
+	const struct trace_step *steps;
+	size_t len;
+	struct trace_press expect[EXPECT_MAX];
+	size_t expect_len;
+};
+
+/* a press or release of button 0 that bounces twice before the level holds */
+#define PRESS(_ms) { BIT(0), 1 }, { 0, 1 }, { BIT(0), _ms }
+#define RELEASE(_ms) { 0, 1 }, { BIT(0), 1 }, { 0, _ms }
+
+/* long enough for a pending short press to be reported */
+#define SETTLE_MS (CONFIG_BUTTON_PRESS_DOUBLE_GAP_MS + 2 * BUTTON_DEBOUNCE_MS)
+
+#define TRACE(_name, _steps, ...)						\
+	{									\
+		.name = _name,							\
+		.steps = _steps,						\
+		.len = ARRAY_SIZE(_steps),					\
+		.expect = { __VA_ARGS__ },					\
+		.expect_len = sizeof((struct trace_press[]){ __VA_ARGS__ }) /	\
+			      sizeof(struct trace_press),			\
+	}
+
+static const struct trace_step short_steps[] = {
+	PRESS(120), RELEASE(SETTLE_MS),
+};
+static const struct trace_step single_steps[] = {
+	PRESS(500), RELEASE(SETTLE_MS),
+};
+static const struct trace_step long_steps[] = {
+	PRESS(1500), RELEASE(SETTLE_MS),
+};
+static const struct trace_step double_steps[] = {
+	PRESS(100), RELEASE(120), PRESS(100), RELEASE(SETTLE_MS),
+};
+static const struct trace_step two_short_steps[] = {
+	PRESS(100), RELEASE(CONFIG_BUTTON_PRESS_DOUBLE_GAP_MS + 150),
+	PRESS(100), RELEASE(SETTLE_MS),
+};
+static const struct trace_step short_long_steps[] = {
+	PRESS(100), RELEASE(100), PRESS(1200), RELEASE(SETTLE_MS),
+};
+/* shorter than the settle time, never a press */
+static const struct trace_step glitch_steps[] = {
+	{ BIT(0), 2 }, { 0, SETTLE_MS },
+};
+#if BUTTON_COUNT >= 2
+/* button 1 held through a short press of button 0, both bouncing */
+static const struct trace_step overlap_steps[] = {
+	{ BIT(1), 1 }, { 0, 1 }, { BIT(1), 100 },
+	{ BIT(1) | BIT(0), 1 }, { BIT(1), 1 }, { BIT(1) | BIT(0), 100 },
+	{ BIT(1), 1 }, { BIT(1) | BIT(0), 1 }, { BIT(1), 400 },
+	{ 0, 1 }, { BIT(1), 1 }, { 0, SETTLE_MS },
+};
+#endif
+
+static const struct trace traces[] = {
+	TRACE("short", short_steps, { 0, BUTTON_PRESS_SHORT }),
+	TRACE("single", single_steps, { 0, BUTTON_PRESS_SINGLE }),
+	TRACE("long", long_steps, { 0, BUTTON_PRESS_LONG }),
+	TRACE("double", double_steps, { 0, BUTTON_PRESS_DOUBLE }),
+	TRACE("two short", two_short_steps, { 0, BUTTON_PRESS_SHORT },
+	      { 0, BUTTON_PRESS_SHORT }),
+	TRACE("short, long", short_long_steps, { 0, BUTTON_PRESS_SHORT },
+	      { 0, BUTTON_PRESS_LONG }),
+	{ .name = "glitch", .steps = glitch_steps, .len = ARRAY_SIZE(glitch_steps) },
+#if BUTTON_COUNT >= 2
+	TRACE("overlap", overlap_steps, { 0, BUTTON_PRESS_SHORT },
+	      { 1, BUTTON_PRESS_SINGLE }),
+#endif
+};
+
+/* the buttons in the order the debouncer numbers them */
+#ifdef CONFIG_BUTTON_PRESS_DEBOUNCE_VCOUNT
+#define BUTTON_SPEC(_node) GPIO_DT_SPEC_GET(_node, gpios),
+
+static const struct gpio_dt_spec buttons[] = {
+	DT_FOREACH_CHILD_STATUS_OKAY(DT_PARENT(DT_ALIAS(sw0)), BUTTON_SPEC)
+};
+#else
+static const struct gpio_dt_spec buttons[] = {
+	GPIO_DT_SPEC_GET(DT_ALIAS(sw0), gpios),
+};
+#endif
+
+BUILD_ASSERT(BUTTON_COUNT <= 8, "trace steps hold one bit per button in a byte");
+
+/* presses classified during the current trace */
+static struct trace_press seen[EXPECT_MAX];
+static size_t seen_len;
+
+void trace_replay_record(uint8_t button, enum button_press_type type,
+			 uint32_t duration_ms)
+{
+	if (seen_len < EXPECT_MAX) {
+		seen[seen_len].button = button;
+		seen[seen_len].type = type;
+	}
+	seen_len++;
+}
+
+/* drive the pins the way the buttons would, honouring their active levels */
+static void set_pressed(uint8_t pressed)
+{
+	for (int i = 0; i < ARRAY_SIZE(buttons); i++) {
+		bool active_low = (buttons[i].dt_flags & GPIO_ACTIVE_LOW) != 0;
+		bool down = (pressed & BIT(i)) != 0;
+
+		gpio_emul_input_set(buttons[i].port, buttons[i].pin, down != active_low);
+	}
+}
+
+static bool replay(const struct trace *trace)
+{
+	seen_len = 0;
+
+	for (size_t i = 0; i < trace->len; i++) {
+		set_pressed(trace->steps[i].pressed);
+		k_msleep(trace->steps[i].ms);
+	}
+
+	if (seen_len != trace->expect_len) {
+		printk("%-12s FAIL: %u presses, expected %u\n", trace->name,
+		       (uint32_t)seen_len, (uint32_t)trace->expect_len);
+		return false;
+	}
+
+	for (size_t i = 0; i < seen_len; i++) {
+		const struct trace_press *want = &trace->expect[i];
+
+		if (seen[i].button != want->button || seen[i].type != want->type) {
+			printk("%-12s FAIL: press %u was %s on button %u, expected %s on %u\n",
+			       trace->name, (uint32_t)i, button_press_name(seen[i].type),
+			       seen[i].button, button_press_name(want->type), want->button);
+			return false;
+		}
+	}
+
+	printk("%-12s ok\n", trace->name);
+	return true;
+}
+
+void trace_replay_run(void)
+{
+	int passed = 0;
+	uint32_t wakeups;
+
+	set_pressed(0);
+	k_msleep(SETTLE_MS);
+
+	for (size_t i = 0; i < ARRAY_SIZE(traces); i++) {
+		passed += replay(&traces[i]) ? 1 : 0;
+	}
+
+	/* with the buttons left alone, nothing should run at all */
+	wakeups = button_wakeups();
+	k_msleep(IDLE_MS);
+	wakeups = button_wakeups() - wakeups;
+
+	printk("idle: %u wakeups in %d ms, polling every %d ms would take %d\n",
+	       wakeups, IDLE_MS, POLL_MS, IDLE_MS / POLL_MS);
+
+	if (passed == ARRAY_SIZE(traces) && button_events_lost() == 0) {
+		printk("trace replay: all %d traces passed\n", passed);
+	} else {
+		printk("trace replay: %d of %d traces passed, %u events lost\n", passed,
+		       (int)ARRAY_SIZE(traces), button_events_lost());
+	}
+}
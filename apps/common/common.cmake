@@ -0,0 +1,15 @@
+# SPDX-License-Identifier: Apache-2.0
+#
+# Code shared by the applications in apps/. Include it from an application's
+# CMakeLists.txt after find_package(Zephyr):
+#
+#   include(${CMAKE_CURRENT_SOURCE_DIR}/../common/common.cmake)
+#
+# Functions an application does not call are dropped by the linker.
+
+target_include_directories(app PRIVATE ${CMAKE_CURRENT_LIST_DIR}/include)
+target_sources(app PRIVATE
+	${CMAKE_CURRENT_LIST_DIR}/src/lat_hist.c
+	${CMAKE_CURRENT_LIST_DIR}/src/ts_fmt.c
+	${CMAKE_CURRENT_LIST_DIR}/src/wallclock.c
+)
@@ -0,0 +1,157 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LAT_HIST_H_
+#define LAT_HIST_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+
+#include <stdint.h>
+
+/*
+ * Log-linear latency histogram in the style of HdrHistogram.
+ *
+ * Each power of two of the value range is split into 2^sub_bits equal
+ * buckets, so every bucket is at most 1/2^sub_bits of its values wide:
+ * 25 % with sub_bits 2, 12.5 % with 3. Values below 2^(sub_bits + 1) get
+ * a bucket each. Values of max_bits bits or more all land in the last
+ * bucket; the exact maximum is kept separately.
+ *
+ * The sum of all values is kept exactly as well, so the mean does not
+ * depend on the bucket width.
+ *
+ * lat_hist_record() only does atomic operations on the bucket counters, the
+ * sum and the minimum and maximum, so it can be called from any thread or
+ * ISR without a lock: one CLZ, a shift, an atomic increment, an atomic add
+ * and two compares, plus a compare-and-swap when a new extreme is seen.
+ * Queries read the counters while records may still come in; their results
+ * are consistent to within the records made meanwhile.
+ */
+struct lat_hist {
+	atomic_t *bucket;
+	uint16_t buckets;
+	uint8_t sub_bits;
+	atomic_t min;
+	atomic_t max;
+	/* sum of all values, low word and carries out of it */
+	atomic_t sum_lo;
+	atomic_t sum_hi;
+};
+
+/* buckets needed for values up to max_bits bits */
+#define LAT_HIST_BUCKETS(_sub_bits, _max_bits) \
+	(((_max_bits) - (_sub_bits) + 1) << (_sub_bits))
+
+/* Static initializer for a histogram over an existing bucket array */
+#define LAT_HIST_INITIALIZER(_bucket, _sub_bits, _max_bits)			\
+	{									\
+		.bucket = (_bucket),						\
+		.buckets = LAT_HIST_BUCKETS(_sub_bits, _max_bits),		\
+		.sub_bits = (_sub_bits),					\
+		.min = ATOMIC_INIT(UINT32_MAX),					\
+		.max = ATOMIC_INIT(0),						\
+		.sum_lo = ATOMIC_INIT(0),					\
+		.sum_hi = ATOMIC_INIT(0),					\
+	}
+
+/*
+ * Define a file-local histogram and its buckets. Use LAT_HIST_INITIALIZER()
+ * for one shared between files.
+ */
+#define LAT_HIST_DEFINE(_name, _sub_bits, _max_bits)				\
+	BUILD_ASSERT((_sub_bits) < (_max_bits) && (_max_bits) <= 32,		\
+		     "invalid range for histogram " #_name);			\
+	static atomic_t _name##_bucket[LAT_HIST_BUCKETS(_sub_bits, _max_bits)]; \
+	static struct lat_hist _name =						\
+		LAT_HIST_INITIALIZER(_name##_bucket, _sub_bits, _max_bits)
+
+/* Bucket of a value. */
+static inline uint32_t lat_hist_index(const struct lat_hist *hist, uint32_t val)
+{
+	uint32_t bits = find_msb_set(val);
+	uint32_t shift = (bits > hist->sub_bits + 1U) ? bits - hist->sub_bits - 1U : 0;
+	uint32_t idx = (shift << hist->sub_bits) + (val >> shift);
+
+	return MIN(idx, hist->buckets - 1U);
+}
+
+void lat_hist_new_min(struct lat_hist *hist, uint32_t val);
+void lat_hist_new_max(struct lat_hist *hist, uint32_t val);
+
+/* Count one value. Lock-free and safe in ISRs. */
+static inline void lat_hist_record(struct lat_hist *hist, uint32_t val)
+{
+	uint32_t old_lo;
+
+	atomic_inc(&hist->bucket[lat_hist_index(hist, val)]);
+
+	old_lo = (uint32_t)atomic_add(&hist->sum_lo, (atomic_val_t)val);
+	if (old_lo + val < old_lo) {
+		atomic_inc(&hist->sum_hi);
+	}
+
+	if (val < (uint32_t)atomic_get(&hist->min)) {
+		lat_hist_new_min(hist, val);
+	}
+	if (val > (uint32_t)atomic_get(&hist->max)) {
+		lat_hist_new_max(hist, val);
+	}
+}
+
+/* Smallest and largest value counted in a bucket. */
+uint32_t lat_hist_bucket_low(const struct lat_hist *hist, uint32_t idx);
+uint32_t lat_hist_bucket_high(const struct lat_hist *hist, uint32_t idx);
+
+/* Number of values counted. */
+uint32_t lat_hist_count(const struct lat_hist *hist);
+
+/* Exact sum of the values counted. */
+uint64_t lat_hist_sum(const struct lat_hist *hist);
+
+/*
+ * Value below or at which per_mille thousandths of the counted values lie,
+ * given as the highest value of its bucket but never more than the
+ * maximum. 0 if nothing was counted.
+ */
+uint32_t lat_hist_percentile(const struct lat_hist *hist, uint32_t per_mille);
+
+struct lat_hist_summary {
+	uint32_t count;
+	uint32_t min;
+	/* exact, rounded down */
+	uint32_t mean;
+	uint32_t p50;
+	uint32_t p90;
+	uint32_t p99;
+	uint32_t max;
+};
+
+/* Summarise a histogram; all fields are 0 if nothing was counted. */
+void lat_hist_summary(const struct lat_hist *hist, struct lat_hist_summary *sum);
+
+/*
+ * Add the counts of src to dst, for example to combine per-CPU or
+ * per-source histograms. Both must have the same layout.
+ *
+ * Returns 0 or -EINVAL if the layouts differ.
+ */
+int lat_hist_merge(struct lat_hist *dst, const struct lat_hist *src);
+
+/* Clear all counts. Records made at the same time may be lost. */
+void lat_hist_reset(struct lat_hist *hist);
+
+/*
+ * Print a histogram on one line with printk():
+ *
+ *   <name>: n <count> min <v> p50 <v> p90 <v> p99 <v> max <v> | s<sub_bits> <idx>:<count> ...
+ *
+ * Values are in the unit they were recorded in. After the bar come the
+ * non-empty buckets, from which a host script can rebuild the histogram
+ * with the bucket bounds of lat_hist_bucket_low() and _high().
+ */
+void lat_hist_dump(const struct lat_hist *hist, const char *name);
+
+#endif /* LAT_HIST_H_ */
@@ -0,0 +1,58 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TS_FMT_H_
+#define TS_FMT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Timestamp formatter for log and telemetry lines.
+ *
+ * Renders a 64-bit tick count as HH:MM:SS.mmm, optionally followed by ,uuu
+ * microseconds, into a caller buffer. Nothing is divided at run time: the
+ * seconds come from a multiplication by the reciprocal of the tick rate,
+ * computed once by ts_fmt_init(), and the digits from multiplications by
+ * reciprocals of 10, 60 and 1000.
+ *
+ * A formatter keeps the HH:MM:SS text of the second it rendered last. A
+ * tick count a few seconds later, the usual case for periodic messages,
+ * only carries the seconds digits forward. Hours take as many digits as
+ * they need.
+ *
+ * A formatter is not locked; give each context its own.
+ */
+
+/* longest timestamp, with 16-digit hours and microseconds, plus the terminator */
+#define TS_FMT_LEN_MAX 32
+
+struct ts_fmt {
+	uint32_t hz;
+	/* floor((2^64 - 1) / hz), turns ticks into seconds */
+	uint64_t sec_recip;
+	/* ceil(2^32 * 10^6 / hz), turns ticks within a second into microseconds */
+	uint64_t us_mul;
+	/* second last rendered and its first tick */
+	uint64_t sec;
+	uint64_t sec_start;
+	/* HH:MM:SS of that second, not terminated */
+	char hms[TS_FMT_LEN_MAX];
+	uint8_t hms_len;
+	bool valid;
+};
+
+/* Set up a formatter for a tick rate of hz per second. */
+void ts_fmt_init(struct ts_fmt *fmt, uint32_t hz);
+
+/*
+ * Render ticks as HH:MM:SS.mmm, or HH:MM:SS.mmm,uuu with us, into buf of at
+ * least TS_FMT_LEN_MAX bytes. Sub-second digits are truncated, not rounded.
+ *
+ * Returns the length, not counting the terminator.
+ */
+size_t ts_fmt_render(struct ts_fmt *fmt, uint64_t ticks, char *buf, bool us);
+
+#endif /* TS_FMT_H_ */
@@ -0,0 +1,43 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef WALLCLOCK_H_
+#define WALLCLOCK_H_
+
+#include <stdint.h>
+
+/*
+ * Cached wall clock for timestamping hot paths.
+ *
+ * A 1 Hz k_timer carries the broken-down time forward by one second,
+ * without dividing, and publishes it through a seqcount latch: two copies,
+ * of which readers always find one that is not being written. Reading is
+ * lock-free and never waits for the writer, so it works from any thread or
+ * ISR, including one that interrupted the update. The fraction of the
+ * current second comes from the cycle counter.
+ *
+ * The timer runs from its own period, so seconds do not drift against the
+ * kernel's uptime; a second starts when its expiry is handled, which may
+ * be a few microseconds after the tick.
+ */
+
+struct wallclock_tm {
+	/* hours since the clock's zero, not wrapped at 24 */
+	uint32_t hours;
+	uint8_t minutes;
+	uint8_t seconds;
+	/* microseconds into the second, from the cycle counter */
+	uint32_t us;
+};
+
+/*
+ * Start the clock at start_sec seconds, for example the time of day read
+ * from an RTC, or 0 to count from now. Call it once, before any reader.
+ */
+void wallclock_start(uint32_t start_sec);
+
+/* Current time. Lock-free and safe in ISRs. */
+void wallclock_get(struct wallclock_tm *tm);
+
+#endif /* WALLCLOCK_H_ */
@@ -0,0 +1,195 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+
+#include "lat_hist.h"
+
+void lat_hist_new_min(struct lat_hist *hist, uint32_t val)
+{
+	atomic_val_t old;
+
+	do {
+		old = atomic_get(&hist->min);
+		if (val >= (uint32_t)old) {
+			return;
+		}
+	} while (!atomic_cas(&hist->min, old, (atomic_val_t)val));
+}
+
+void lat_hist_new_max(struct lat_hist *hist, uint32_t val)
+{
+	atomic_val_t old;
+
+	do {
+		old = atomic_get(&hist->max);
+		if (val <= (uint32_t)old) {
+			return;
+		}
+	} while (!atomic_cas(&hist->max, old, (atomic_val_t)val));
+}
+
+/* shift of the values in a bucket relative to their top sub_bits + 1 bits */
+static inline uint32_t bucket_shift(const struct lat_hist *hist, uint32_t idx)
+{
+	return MAX(idx >> hist->sub_bits, 1U) - 1U;
+}
+
+uint32_t lat_hist_bucket_low(const struct lat_hist *hist, uint32_t idx)
+{
+	uint32_t shift = bucket_shift(hist, idx);
+
+	return (idx - (shift << hist->sub_bits)) << shift;
+}
+
+uint32_t lat_hist_bucket_high(const struct lat_hist *hist, uint32_t idx)
+{
+	uint32_t shift = bucket_shift(hist, idx);
+
+	if (idx == hist->buckets - 1U) {
+		/* everything above the range */
+		return UINT32_MAX;
+	}
+
+	return lat_hist_bucket_low(hist, idx) + BIT(shift) - 1U;
+}
+
+uint32_t lat_hist_count(const struct lat_hist *hist)
+{
+	uint32_t count = 0;
+
+	for (uint32_t i = 0; i < hist->buckets; i++) {
+		count += (uint32_t)atomic_get(&hist->bucket[i]);
+	}
+
+	return count;
+}
+
+uint64_t lat_hist_sum(const struct lat_hist *hist)
+{
+	uint32_t hi;
+	uint32_t lo;
+
+	/* retry if a carry happened between reading the two words */
+	do {
+		hi = (uint32_t)atomic_get(&hist->sum_hi);
+		lo = (uint32_t)atomic_get(&hist->sum_lo);
+	} while ((uint32_t)atomic_get(&hist->sum_hi) != hi);
+
+	return ((uint64_t)hi << 32) | lo;
+}
+
+/* Bucket holding the value of rank 1..count, given the bucket counts. */
+static uint32_t rank_value(const struct lat_hist *hist, uint32_t rank)
+{
+	uint32_t seen = 0;
+
+	for (uint32_t i = 0; i < hist->buckets; i++) {
+		seen += (uint32_t)atomic_get(&hist->bucket[i]);
+		if (seen >= rank) {
+			return MIN(lat_hist_bucket_high(hist, i),
+				   (uint32_t)atomic_get(&hist->max));
+		}
+	}
+
+	/* counts went down meanwhile, a reset raced with the query */
+	return (uint32_t)atomic_get(&hist->max);
+}
+
+static uint32_t percentile(const struct lat_hist *hist, uint32_t count,
+			   uint32_t per_mille)
+{
+	/* smallest rank that covers per_mille of the values */
+	uint32_t rank = (uint32_t)(((uint64_t)count * per_mille + 999U) / 1000U);
+
+	return rank_value(hist, MAX(rank, 1U));
+}
+
+uint32_t lat_hist_percentile(const struct lat_hist *hist, uint32_t per_mille)
+{
+	uint32_t count = lat_hist_count(hist);
+
+	return (count > 0) ? percentile(hist, count, per_mille) : 0;
+}
+
+void lat_hist_summary(const struct lat_hist *hist, struct lat_hist_summary *sum)
+{
+	uint32_t count = lat_hist_count(hist);
+
+	*sum = (struct lat_hist_summary){ 0 };
+
+	if (count == 0) {
+		return;
+	}
+
+	sum->count = count;
+	sum->min = (uint32_t)atomic_get(&hist->min);
+	sum->mean = (uint32_t)(lat_hist_sum(hist) / count);
+	sum->p50 = percentile(hist, count, 500);
+	sum->p90 = percentile(hist, count, 900);
+	sum->p99 = percentile(hist, count, 990);
+	sum->max = (uint32_t)atomic_get(&hist->max);
+}
+
+int lat_hist_merge(struct lat_hist *dst, const struct lat_hist *src)
+{
+	if (dst->buckets != src->buckets || dst->sub_bits != src->sub_bits) {
+		return -EINVAL;
+	}
+
+	for (uint32_t i = 0; i < src->buckets; i++) {
+		atomic_val_t n = atomic_get(&src->bucket[i]);
+
+		if (n != 0) {
+			atomic_add(&dst->bucket[i], n);
+		}
+	}
+
+	if (lat_hist_count(src) > 0) {
+		uint64_t add = lat_hist_sum(src);
+		uint32_t lo = (uint32_t)add;
+		uint32_t old_lo = (uint32_t)atomic_add(&dst->sum_lo, (atomic_val_t)lo);
+		uint32_t carry = (old_lo + lo < old_lo) ? 1 : 0;
+
+		atomic_add(&dst->sum_hi, (atomic_val_t)((uint32_t)(add >> 32) + carry));
+
+		lat_hist_new_min(dst, (uint32_t)atomic_get(&src->min));
+		lat_hist_new_max(dst, (uint32_t)atomic_get(&src->max));
+	}
+
+	return 0;
+}
+
+void lat_hist_reset(struct lat_hist *hist)
+{
+	for (uint32_t i = 0; i < hist->buckets; i++) {
+		atomic_clear(&hist->bucket[i]);
+	}
+
+	atomic_set(&hist->min, (atomic_val_t)UINT32_MAX);
+	atomic_set(&hist->max, 0);
+	atomic_clear(&hist->sum_lo);
+	atomic_clear(&hist->sum_hi);
+}
+
+void lat_hist_dump(const struct lat_hist *hist, const char *name)
+{
+	struct lat_hist_summary sum;
+
+	lat_hist_summary(hist, &sum);
+
+	printk("%s: n %u min %u p50 %u p90 %u p99 %u max %u | s%u", name,
+	       sum.count, sum.min, sum.p50, sum.p90, sum.p99, sum.max,
+	       hist->sub_bits);
+
+	for (uint32_t i = 0; i < hist->buckets; i++) {
+		uint32_t n = (uint32_t)atomic_get(&hist->bucket[i]);
+
+		if (n != 0) {
+			printk(" %u:%u", i, n);
+		}
+	}
+
+	printk("\n");
+}
@@ -0,0 +1,183 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/sys/util.h>
+
+#include <string.h>
+
+#include "ts_fmt.h"
+
+/* seconds a render may move forward by carrying digits, beyond that it converts */
+#define CARRY_MAX_SEC 4
+
+/* (a * b) >> 64, from four 32x32 multiplications */
+static uint64_t mul_hi64(uint64_t a, uint64_t b)
+{
+	uint64_t a_lo = (uint32_t)a;
+	uint64_t a_hi = a >> 32;
+	uint64_t b_lo = (uint32_t)b;
+	uint64_t b_hi = b >> 32;
+	uint64_t lo_lo = a_lo * b_lo;
+	uint64_t hi_lo = a_hi * b_lo;
+	uint64_t lo_hi = a_lo * b_hi;
+	uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+
+	return a_hi * b_hi + (hi_lo >> 32) + (cross >> 32);
+}
+
+/*
+ * n / d given recip = floor((2^64 - 1) / d). The estimate is at most one
+ * short, the remainder tells.
+ */
+static uint64_t div_recip(uint64_t n, uint64_t d, uint64_t recip, uint64_t *rem)
+{
+	uint64_t q = mul_hi64(n, recip);
+	uint64_t r = n - q * d;
+
+	if (r >= d) {
+		q++;
+		r -= d;
+	}
+
+	*rem = r;
+	return q;
+}
+
+/* two digits of v < 100; (v * 205) >> 11 is v / 10 for v < 1029 */
+static char *put2(char *p, uint32_t v)
+{
+	uint32_t tens = (v * 205U) >> 11;
+
+	p[0] = '0' + tens;
+	p[1] = '0' + (v - tens * 10U);
+	return p + 2;
+}
+
+/* three digits of v < 1000; (v * 41) >> 12 is v / 100 for v < 1000 */
+static char *put3(char *p, uint32_t v)
+{
+	uint32_t hundreds = (v * 41U) >> 12;
+
+	p[0] = '0' + hundreds;
+	return put2(p + 1, v - hundreds * 100U);
+}
+
+/* HH:MM:SS of fmt->sec */
+static void render_hms(struct ts_fmt *fmt)
+{
+	char digits[20];
+	int n = 0;
+	uint64_t rem;
+	uint64_t hours = div_recip(fmt->sec, 3600U, UINT64_MAX / 3600U, &rem);
+	/* (rem * 4370) >> 18 is rem / 60 for rem < 3600 */
+	uint32_t minutes = ((uint32_t)rem * 4370U) >> 18;
+	char *p = fmt->hms;
+
+	/* 0xCCCCCCCCCCCCCCCD / 2^67 is 1 / 10 exactly enough for any 64-bit value */
+	do {
+		uint64_t q = mul_hi64(hours, 0xCCCCCCCCCCCCCCCDULL) >> 3;
+
+		digits[n++] = '0' + (char)(hours - q * 10U);
+		hours = q;
+	} while (hours > 0);
+
+	if (n < 2) {
+		digits[n++] = '0';
+	}
+
+	while (n > 0) {
+		*p++ = digits[--n];
+	}
+
+	*p++ = ':';
+	p = put2(p, minutes);
+	*p++ = ':';
+	p = put2(p, (uint32_t)rem - minutes * 60U);
+
+	fmt->hms_len = p - fmt->hms;
+}
+
+/* Move fmt->hms on by one second, carrying through the minutes. */
+static void carry_second(struct ts_fmt *fmt)
+{
+	/* units of seconds, tens of seconds two before, minutes before the colon */
+	char *s = &fmt->hms[fmt->hms_len - 1];
+
+	fmt->sec++;
+
+	if (s[0] != '9') {
+		s[0]++;
+		return;
+	}
+	s[0] = '0';
+	if (s[-1] != '5') {
+		s[-1]++;
+		return;
+	}
+	s[-1] = '0';
+	if (s[-3] != '9') {
+		s[-3]++;
+		return;
+	}
+	s[-3] = '0';
+	if (s[-4] != '5') {
+		s[-4]++;
+		return;
+	}
+
+	/* a new hour, which may need another digit */
+	render_hms(fmt);
+}
+
+void ts_fmt_init(struct ts_fmt *fmt, uint32_t hz)
+{
+	memset(fmt, 0, sizeof(*fmt));
+
+	fmt->hz = hz;
+	fmt->sec_recip = UINT64_MAX / hz;
+	fmt->us_mul = ((1000000ULL << 32) + hz - 1U) / hz;
+}
+
+size_t ts_fmt_render(struct ts_fmt *fmt, uint64_t ticks, char *buf, bool us)
+{
+	uint64_t carry_max = (uint64_t)fmt->hz * CARRY_MAX_SEC;
+	uint64_t frac;
+	uint32_t sub_us;
+	uint32_t ms;
+	char *p;
+
+	if (!fmt->valid || ticks < fmt->sec_start || ticks - fmt->sec_start >= carry_max) {
+		fmt->sec = div_recip(ticks, fmt->hz, fmt->sec_recip, &frac);
+		fmt->sec_start = ticks - frac;
+		fmt->valid = true;
+		render_hms(fmt);
+	} else {
+		while (ticks - fmt->sec_start >= fmt->hz) {
+			fmt->sec_start += fmt->hz;
+			carry_second(fmt);
+		}
+		frac = ticks - fmt->sec_start;
+	}
+
+	/* us_mul was rounded up, so the product is at most one above */
+	sub_us = (uint32_t)((frac * fmt->us_mul) >> 32);
+	if ((uint64_t)sub_us * fmt->hz > frac * 1000000U) {
+		sub_us--;
+	}
+
+	/* (v * 274877907) >> 38 is v / 1000 for any 32-bit v */
+	ms = (uint32_t)(((uint64_t)sub_us * 274877907U) >> 38);
+
+	memcpy(buf, fmt->hms, fmt->hms_len);
+	p = buf + fmt->hms_len;
+	*p++ = '.';
+	p = put3(p, ms);
+	if (us) {
+		*p++ = ',';
+		p = put3(p, sub_us - ms * 1000U);
+	}
+	*p = '\0';
+
+	return p - buf;
+}
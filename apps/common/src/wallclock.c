@@ -0,0 +1,100 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/barrier.h>
+
+#include "wallclock.h"
+
+struct wallclock_state {
+	/* us is not used, readers fill it in */
+	struct wallclock_tm tm;
+	/* cycle count the second started at */
+	uint32_t cyc;
+};
+
+/*
+ * Seqcount latch: readers use copy[seq & 1]. The writer bumps seq to move
+ * them over to copy[1], rewrites copy[0], bumps it again and then rewrites
+ * copy[1], so the copy being written is never the one being read.
+ */
+static atomic_t seq;
+static struct wallclock_state copy[2];
+
+/* ceil(2^32 * 10^6 / cycles per second), cycles to microseconds */
+static uint64_t us_mul;
+
+static struct k_timer second_timer;
+
+static void latch_write(const struct wallclock_state *st)
+{
+	atomic_inc(&seq);
+	barrier_dmem_fence_full();
+	copy[0] = *st;
+	barrier_dmem_fence_full();
+	atomic_inc(&seq);
+	barrier_dmem_fence_full();
+	copy[1] = *st;
+}
+
+/* The only writer, in the timer interrupt. */
+static void second_expiry(struct k_timer *timer_id)
+{
+	struct wallclock_state st = copy[0];
+
+	st.cyc = k_cycle_get_32();
+
+	if (++st.tm.seconds == 60) {
+		st.tm.seconds = 0;
+		if (++st.tm.minutes == 60) {
+			st.tm.minutes = 0;
+			st.tm.hours++;
+		}
+	}
+
+	latch_write(&st);
+}
+
+void wallclock_start(uint32_t start_sec)
+{
+	struct wallclock_state st = {
+		.tm = {
+			.hours = start_sec / 3600U,
+			.minutes = (start_sec / 60U) % 60U,
+			.seconds = start_sec % 60U,
+		},
+	};
+
+	us_mul = ((1000000ULL << 32) + sys_clock_hw_cycles_per_sec() - 1U) /
+		 sys_clock_hw_cycles_per_sec();
+
+	k_timer_init(&second_timer, second_expiry, NULL);
+
+	st.cyc = k_cycle_get_32();
+	latch_write(&st);
+	k_timer_start(&second_timer, K_SECONDS(1), K_SECONDS(1));
+}
+
+void wallclock_get(struct wallclock_tm *tm)
+{
+	struct wallclock_state st;
+	atomic_val_t start;
+	uint32_t now;
+	uint32_t us;
+
+	do {
+		start = atomic_get(&seq);
+		barrier_dmem_fence_full();
+		st = copy[start & 1];
+		now = k_cycle_get_32();
+		barrier_dmem_fence_full();
+	} while (atomic_get(&seq) != start);
+
+	/* a late expiry must not let the fraction run past the second */
+	us = (uint32_t)(((uint64_t)(now - st.cyc) * us_mul) >> 32);
+
+	*tm = st.tm;
+	tm->us = MIN(us, 999999U);
+}
@@ -7,6 +7,7 @@
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
 #include <zephyr/drivers/uart.h>
+#include <zephyr/sys/ring_buffer.h>
 
 #include <string.h>
 
@@ -15,64 +16,205 @@
 
 #define MSG_SIZE 32
 
-/* queue to store up to 10 messages (aligned to 4-byte boundary) */
-K_MSGQ_DEFINE(uart_msgq, MSG_SIZE, 10, 4);
+/*
+ * A received line. The UART ISR assembles it directly in a block from
+ * rx_slab and passes the block by pointer through rx_fifo; main() frees it
+ * once the reply is queued, so the line is never copied on its way.
+ */
+struct rx_line {
+	/* first word reserved for use by k_fifo */
+	void *fifo_reserved;
+	uint16_t len;
+	char buf[MSG_SIZE];
+};
+
+/* pool of up to 10 lines (aligned to 4-byte boundary) */
+K_MEM_SLAB_DEFINE_STATIC(rx_slab, sizeof(struct rx_line), 10, 4);
+K_FIFO_DEFINE(rx_fifo);
 
 static const struct device *const uart_dev = DEVICE_DT_GET(UART_DEVICE_NODE);
 
-/* receive buffer used in UART ISR callback */
-static char rx_buf[MSG_SIZE];
-static int rx_buf_pos;
+/*
+ * transmit ring, filled by uart_write() and drained by the TX interrupt;
+ * tx_lock serialises writers against each other and against the drain
+ */
+#define TX_RING_SIZE 256
+
+RING_BUF_DECLARE(tx_ring, TX_RING_SIZE);
+static struct k_spinlock tx_lock;
+
+/* given whenever the TX interrupt has made room in tx_ring */
+static K_SEM_DEFINE(tx_space, 0, 1);
+
+/* one fragment of a reply passed to uart_writev() */
+struct uart_iov {
+	const void *base;
+	size_t len;
+};
+
+/* line being assembled in UART ISR callback, NULL until its first byte */
+static struct rx_line *rx_line;
+/* no block was free for the current line, skip it up to the line end */
+static bool rx_line_skip;
 
 /*
- * Read characters from UART until line end is detected. Afterwards push the
- * data to the message queue.
+ * Fill the TX FIFO from tx_ring, and stop the TX interrupt once the ring
+ * is empty.
  */
-void serial_cb(const struct device *dev, void *user_data)
+static void serial_tx(void)
 {
-	uint8_t c;
+	k_spinlock_key_t key = k_spin_lock(&tx_lock);
+	uint8_t *data;
+	uint32_t len = ring_buf_get_claim(&tx_ring, &data, TX_RING_SIZE);
+	int sent;
 
-	if (!uart_irq_update(uart_dev)) {
+	if (len == 0) {
+		uart_irq_tx_disable(uart_dev);
+		k_spin_unlock(&tx_lock, key);
 		return;
 	}
 
-	if (!uart_irq_rx_ready(uart_dev)) {
-		return;
-	}
+	sent = uart_fifo_fill(uart_dev, data, len);
+	ring_buf_get_finish(&tx_ring, MAX(sent, 0));
+
+	k_spin_unlock(&tx_lock, key);
+
+	k_sem_give(&tx_space);
+}
+
+/*
+ * Read characters from UART until line end is detected. Afterwards pass the
+ * line to main() through the FIFO.
+ */
+static void serial_rx(void)
+{
+	uint8_t c;
 
 	/* read until FIFO empty */
 	while (uart_fifo_read(uart_dev, &c, 1) == 1) {
-		if ((c == '\n' || c == '\r') && rx_buf_pos > 0) {
-			/* terminate string */
-			rx_buf[rx_buf_pos] = '\0';
+		if (c == '\n' || c == '\r') {
+			if (rx_line != NULL) {
+				/* terminate string */
+				rx_line->buf[rx_line->len] = '\0';
+
+				/* hand the block over, main() frees it */
+				k_fifo_put(&rx_fifo, rx_line);
+				rx_line = NULL;
+			}
+			rx_line_skip = false;
+			continue;
+		}
 
-			/* if queue is full, message is silently dropped */
-			k_msgq_put(&uart_msgq, &rx_buf, K_NO_WAIT);
+		if (rx_line == NULL && !rx_line_skip) {
+			/* if all blocks are in use, the line is dropped */
+			if (k_mem_slab_alloc(&rx_slab, (void **)&rx_line,
+					     K_NO_WAIT) != 0) {
+				rx_line = NULL;
+				rx_line_skip = true;
+				continue;
+			}
+			rx_line->len = 0;
+		}
 
-			/* reset the buffer (it was copied to the msgq) */
-			rx_buf_pos = 0;
-		} else if (rx_buf_pos < (sizeof(rx_buf) - 1)) {
-			rx_buf[rx_buf_pos++] = c;
+		if (rx_line != NULL && rx_line->len < (MSG_SIZE - 1)) {
+			rx_line->buf[rx_line->len++] = c;
 		}
 		/* else: characters beyond buffer size are dropped */
 	}
 }
 
+void serial_cb(const struct device *dev, void *user_data)
+{
+	if (!uart_irq_update(uart_dev)) {
+		return;
+	}
+
+	if (uart_irq_rx_ready(uart_dev)) {
+		serial_rx();
+	}
+
+	if (uart_irq_tx_ready(uart_dev)) {
+		serial_tx();
+	}
+}
+
+/*
+ * Queue up to len bytes for transmission without blocking. Returns the
+ * number of bytes accepted, which is less than len if the TX ring is full.
+ */
+int uart_write(const void *buf, size_t len)
+{
+	k_spinlock_key_t key = k_spin_lock(&tx_lock);
+	uint32_t accepted = ring_buf_put(&tx_ring, buf, len);
+
+	k_spin_unlock(&tx_lock, key);
+
+	if (accepted > 0) {
+		/* the TX interrupt drains the ring from here on */
+		uart_irq_tx_enable(uart_dev);
+	}
+
+	return accepted;
+}
+
+/*
+ * Queue all fragments of iov as one contiguous transmission without
+ * blocking and without concatenating them first. Either every fragment is
+ * queued or none; returns the total number of bytes queued, or -EAGAIN if
+ * the TX ring does not have room for all of them yet.
+ */
+int uart_writev(const struct uart_iov *iov, size_t iovcnt)
+{
+	k_spinlock_key_t key;
+	size_t total = 0;
+
+	for (size_t i = 0; i < iovcnt; i++) {
+		total += iov[i].len;
+	}
+
+	key = k_spin_lock(&tx_lock);
+
+	if (ring_buf_space_get(&tx_ring) < total) {
+		k_spin_unlock(&tx_lock, key);
+		return -EAGAIN;
+	}
+
+	for (size_t i = 0; i < iovcnt; i++) {
+		ring_buf_put(&tx_ring, iov[i].base, iov[i].len);
+	}
+
+	k_spin_unlock(&tx_lock, key);
+
+	if (total > 0) {
+		uart_irq_tx_enable(uart_dev);
+	}
+
+	return total;
+}
+
 /*
- * Print a null-terminated string character by character to the UART interface
+ * Queue a null-terminated string for transmission, waiting only while the
+ * TX ring is full
  */
 void print_uart(char *buf)
 {
-	int msg_len = strlen(buf);
+	size_t len = strlen(buf);
+	int ret;
 
-	for (int i = 0; i < msg_len; i++) {
-		uart_poll_out(uart_dev, buf[i]);
+	while (len > 0) {
+		ret = uart_write(buf, len);
+		if (ret == 0) {
+			k_sem_take(&tx_space, K_FOREVER);
+			continue;
+		}
+		buf += ret;
+		len -= ret;
 	}
 }
 
 int main(void)
 {
-	char tx_buf[MSG_SIZE];
+	struct rx_line *line;
 
 	if (!device_is_ready(uart_dev)) {
 		printk("UART device not found!");
@@ -98,10 +240,20 @@ int main(void)
 	print_uart("Tell me something and press enter:\r\n");
 
 	/* indefinitely wait for input from the user */
-	while (k_msgq_get(&uart_msgq, &tx_buf, K_FOREVER) == 0) {
-		print_uart("Echo: ");
-		print_uart(tx_buf);
-		print_uart("\r\n");
+	while ((line = k_fifo_get(&rx_fifo, K_FOREVER)) != NULL) {
+		struct uart_iov reply[] = {
+			{ "Echo: ", 6 },
+			{ line->buf, line->len },
+			{ "\r\n", 2 },
+		};
+
+		/* a reply always fits the TX ring, wait until there is room */
+		while (uart_writev(reply, ARRAY_SIZE(reply)) == -EAGAIN) {
+			k_sem_take(&tx_space, K_FOREVER);
+		}
+
+		/* the reply was copied into the TX ring, the block can go */
+		k_mem_slab_free(&rx_slab, line);
 	}
 	return 0;
 }
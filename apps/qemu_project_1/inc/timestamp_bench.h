@@ -0,0 +1,14 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TIMESTAMP_BENCH_H_
+#define TIMESTAMP_BENCH_H_
+
+/*
+ * Print the cycles per call of ts_fmt_render() and of the create_timestamp()
+ * it replaced, enabled with CONFIG_TIMESTAMP_BENCH.
+ */
+void timestamp_bench(void);
+
+#endif /* TIMESTAMP_BENCH_H_ */
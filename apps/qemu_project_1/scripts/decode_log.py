@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: Apache-2.0
+
+"""Decode the output of a dictionary logging build (see dictionary.conf).
+
+Wraps Zephyr's scripts/logging/dictionary/log_parser.py and
+log_parser_uart.py, which look the format strings up in the database the
+build writes to zephyr/log_dictionary.json.
+
+The log is read from a file holding the raw bytes from the UART, or with
+--hex from a console capture of a build with
+CONFIG_LOG_BACKEND_UART_OUTPUT_DICTIONARY_HEX, for example QEMU's output,
+from which the hex lines are picked. --serial decodes a live port instead.
+
+--stats also prints how many bytes went over the wire against the size of
+the decoded text. With --hex the wire bytes are those of the hex lines,
+line ends included, not of the records they decode to.
+"""
+
+import argparse
+import binascii
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+# lines holding nothing but hex digits, as the UART backend prints them
+HEX_LINE_RE = re.compile(r'^\s*([0-9a-fA-F]+)\s*$')
+
+
+def parser_script(zephyr_base, name):
+    path = os.path.join(zephyr_base, 'scripts', 'logging', 'dictionary', name)
+    if not os.path.isfile(path):
+        sys.exit('decode_log: {} not found, is ZEPHYR_BASE set?'.format(path))
+    return path
+
+
+def hex_to_bin(path):
+    """Return the bytes of the hex lines in a console capture, and the
+    number of bytes those lines took on the wire."""
+    hexdata = []
+    wire = 0
+    # newline='' keeps CR LF line ends as they were sent
+    with open(path, encoding='iso-8859-1', newline='') as f:
+        for line in f:
+            m = HEX_LINE_RE.match(line)
+            if m and len(m.group(1)) % 2 == 0:
+                hexdata.append(m.group(1))
+                wire += len(line)
+    if not hexdata:
+        sys.exit('decode_log: no hex log records in ' + path)
+    return binascii.unhexlify(''.join(hexdata)), wire
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('-d', '--build-dir', default='build',
+                        help='build directory of the application (default: build)')
+    parser.add_argument('--db', help='log database, default '
+                        '<build-dir>/zephyr/log_dictionary.json')
+    parser.add_argument('--zephyr-base', default=os.environ.get('ZEPHYR_BASE'))
+    parser.add_argument('--hex', action='store_true',
+                        help='the log is a console capture of hex records')
+    parser.add_argument('--serial', metavar='PORT', help='decode a live serial port')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--stats', action='store_true',
+                        help='compare bytes on the wire with the decoded text')
+    parser.add_argument('logfile', nargs='?')
+    args = parser.parse_args()
+
+    if not args.zephyr_base:
+        sys.exit('decode_log: set ZEPHYR_BASE or pass --zephyr-base')
+
+    db = args.db or os.path.join(args.build_dir, 'zephyr', 'log_dictionary.json')
+    if not os.path.isfile(db):
+        sys.exit('decode_log: no log database at {}, build with '
+                 '-DEXTRA_CONF_FILE=dictionary.conf'.format(db))
+
+    if args.serial:
+        script = parser_script(args.zephyr_base, 'log_parser_uart.py')
+        return subprocess.call([sys.executable, script, db, args.serial,
+                                str(args.baud)])
+
+    if not args.logfile:
+        parser.error('a log file or --serial is needed')
+
+    if args.hex:
+        data, wire = hex_to_bin(args.logfile)
+    else:
+        with open(args.logfile, 'rb') as f:
+            data = f.read()
+        wire = len(data)
+
+    # log_parser.py reads the raw records from a file
+    with tempfile.NamedTemporaryFile(suffix='.bin', delete=False) as f:
+        f.write(data)
+        binfile = f.name
+
+    try:
+        script = parser_script(args.zephyr_base, 'log_parser.py')
+        result = subprocess.run([sys.executable, script, db, binfile],
+                                stdout=subprocess.PIPE, check=False)
+    finally:
+        os.unlink(binfile)
+
+    sys.stdout.buffer.write(result.stdout)
+
+    if args.stats and result.returncode == 0:
+        lines = result.stdout.count(b'\n')
+        print('wire {} bytes, text {} bytes in {} lines, {:.1f}x'.format(
+            wire, len(result.stdout), lines,
+            len(result.stdout) / max(wire, 1)), file=sys.stderr)
+
+    return result.returncode
+
+
+if __name__ == '__main__':
+    sys.exit(main())
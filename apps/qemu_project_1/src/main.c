@@ -8,45 +8,71 @@
 #include <zephyr/device.h>
 #include <zephyr/devicetree.h>
 #include <zephyr/drivers/gpio.h>
+#include <zephyr/logging/log.h>
 #include <string.h>
 
+#include "ts_fmt.h"
+#include "timestamp_bench.h"
+
+LOG_MODULE_REGISTER(main, LOG_LEVEL_INF);
+
 volatile bool led_state = false;
 
 struct k_timer timer;
 
-void create_timestamp(const uint32_t count)
-{
-	uint32_t c = count;
-	uint8_t seconds = c % 60;
-	uint8_t minutes = ((c / 60) % 60);
-	uint32_t hours = c / 3600;
-	uint8_t time_stamp[6] = {0};
+/* renders the LED timestamps, only used by timer_handler() */
+static struct ts_fmt ts;
 
-	time_stamp[0] = 0x30 + hours/10;
-	time_stamp[1] = 0x30 + hours%10;
+#define PERIOD K_SECONDS(1)
 
-	time_stamp[2] = 0x30 + minutes/10;
-	time_stamp[3] = 0x30 + minutes%10;
+/* absolute tick the next expiry is due at, see main() */
+static int64_t due_tick;
 
-	time_stamp[4] = 0x30 + seconds/10;
-	time_stamp[5] = 0x30 + seconds%10;
-
-	printk("[%c%c:%c%c:%c%c.000] ", time_stamp[0], time_stamp[1], time_stamp[2], time_stamp[3], time_stamp[4], time_stamp[5]);
-}
+/* ticks the last expiry was late by, and the most so far */
+static int32_t drift;
+static int32_t drift_max;
 
+/*
+ * The timer reloads itself from its period, counted from the previous
+ * deadline rather than from now, so nothing needs re-arming here. Each
+ * expiry is checked against the absolute tick it was due at: drift_max
+ * stays 0 as long as no expiry was handled late, however long it runs.
+ *
+ * This runs in the timer interrupt. LOG_INF() only copies the arguments,
+ * including the timestamp string, into the log buffer; the logging thread
+ * formats them and waits for the UART later.
+ */
 void timer_handler(struct k_timer *timer_id)
 {
-	static uint32_t count = 0;
+	char time_stamp[TS_FMT_LEN_MAX];
+
+	drift = (int32_t)(k_uptime_ticks() - due_tick);
+	drift_max = MAX(drift_max, drift);
+	due_tick += PERIOD.ticks;
+
 	led_state = !led_state;
-	count++;
-	create_timestamp(count);
-	printk("LED state: %d\n", led_state);
-	k_timer_start(&timer, K_SECONDS(1), K_SECONDS(1));
+
+	if (IS_ENABLED(CONFIG_LOG_DICTIONARY_SUPPORT)) {
+		/* the decoder prints the message's own timestamp, keep the record small */
+		LOG_INF("LED state: %d drift %d ticks (max %d)", led_state, drift, drift_max);
+	} else {
+		ts_fmt_render(&ts, k_uptime_ticks(), time_stamp, false);
+		LOG_INF("[%s] LED state: %d drift %d ticks (max %d)", time_stamp, led_state,
+			drift, drift_max);
+	}
 }
 
 int main(void)
 {
+#ifdef CONFIG_TIMESTAMP_BENCH
+	timestamp_bench();
+#endif
+
+	ts_fmt_init(&ts, CONFIG_SYS_CLOCK_TICKS_PER_SEC);
 	k_timer_init(&timer, timer_handler, NULL);
-	k_timer_start(&timer, K_SECONDS(1), K_SECONDS(1));
+
+	/* first expiry on an absolute tick, the ones after it follow from the period */
+	due_tick = k_uptime_ticks() + PERIOD.ticks;
+	k_timer_start(&timer, K_TIMEOUT_ABS_TICKS(due_tick), PERIOD);
 	return 0;
 }
@@ -0,0 +1,116 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+
+#include <string.h>
+
+#include "timestamp_bench.h"
+#include "ts_fmt.h"
+
+#define BENCH_ROUNDS 1000
+
+/* a day and a bit in, so the hours have two digits */
+#define BENCH_START_SEC 90061U
+
+/*
+ * The formatter main.c used before ts_fmt, kept as the baseline: six
+ * divisions per call, hours cut to two digits, milliseconds always .000.
+ */
+static void create_timestamp(const uint32_t count, char *time_stamp)
+{
+	uint32_t c = count;
+	uint8_t seconds = c % 60;
+	uint8_t minutes = ((c / 60) % 60);
+	uint32_t hours = c / 3600;
+
+	time_stamp[0] = 0x30 + hours/10;
+	time_stamp[1] = 0x30 + hours%10;
+	time_stamp[2] = ':';
+
+	time_stamp[3] = 0x30 + minutes/10;
+	time_stamp[4] = 0x30 + minutes%10;
+	time_stamp[5] = ':';
+
+	time_stamp[6] = 0x30 + seconds/10;
+	time_stamp[7] = 0x30 + seconds%10;
+
+	memcpy(&time_stamp[8], ".000", 5);
+}
+
+/* cycles spent by a back-to-back pair of k_cycle_get_32() calls */
+static uint32_t bench_overhead(void)
+{
+	uint32_t best = UINT32_MAX;
+
+	for (int i = 0; i < 16; i++) {
+		uint32_t start = k_cycle_get_32();
+
+		best = MIN(best, k_cycle_get_32() - start);
+	}
+
+	return best;
+}
+
+static uint32_t bench_legacy(uint32_t overhead, char *buf)
+{
+	uint64_t cycles = 0;
+
+	for (uint32_t i = 0; i < BENCH_ROUNDS; i++) {
+		uint32_t start = k_cycle_get_32();
+		uint32_t elapsed;
+
+		create_timestamp(BENCH_START_SEC + i, buf);
+		compiler_barrier();
+		elapsed = k_cycle_get_32() - start;
+
+		cycles += elapsed > overhead ? elapsed - overhead : 0;
+	}
+
+	return (uint32_t)(cycles / BENCH_ROUNDS);
+}
+
+/* render ticks that advance by step each call */
+static uint32_t bench_ts_fmt(uint32_t overhead, char *buf, uint64_t step, bool us)
+{
+	struct ts_fmt fmt;
+	uint64_t ticks = (uint64_t)BENCH_START_SEC * CONFIG_SYS_CLOCK_TICKS_PER_SEC;
+	uint64_t cycles = 0;
+
+	ts_fmt_init(&fmt, CONFIG_SYS_CLOCK_TICKS_PER_SEC);
+
+	for (uint32_t i = 0; i < BENCH_ROUNDS; i++) {
+		uint32_t start = k_cycle_get_32();
+		uint32_t elapsed;
+
+		ts_fmt_render(&fmt, ticks, buf, us);
+		compiler_barrier();
+		elapsed = k_cycle_get_32() - start;
+
+		cycles += elapsed > overhead ? elapsed - overhead : 0;
+		ticks += step;
+	}
+
+	return (uint32_t)(cycles / BENCH_ROUNDS);
+}
+
+void timestamp_bench(void)
+{
+	static char buf[TS_FMT_LEN_MAX];
+	const uint64_t sec = CONFIG_SYS_CLOCK_TICKS_PER_SEC;
+	uint32_t overhead = bench_overhead();
+
+	printk("timestamp benchmark, %d rounds each, %u ticks/s\n", BENCH_ROUNDS,
+	       CONFIG_SYS_CLOCK_TICKS_PER_SEC);
+
+	printk("%-36s %5u cycles/call\n", "create_timestamp()",
+	       bench_legacy(overhead, buf));
+	printk("%-36s %5u cycles/call\n", "ts_fmt_render() every second",
+	       bench_ts_fmt(overhead, buf, sec, false));
+	printk("%-36s %5u cycles/call\n", "ts_fmt_render() every 10 ms, with us",
+	       bench_ts_fmt(overhead, buf, MAX(sec / 100, 1), true));
+	/* over a minute apart, every call converts from scratch */
+	printk("%-36s %5u cycles/call\n", "ts_fmt_render() every 61 s",
+	       bench_ts_fmt(overhead, buf, sec * 61 + 1, false));
+}
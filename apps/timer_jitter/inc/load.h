@@ -0,0 +1,22 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LOAD_H_
+#define LOAD_H_
+
+/*
+ * Background load enabled with CONFIG_TIMER_JITTER_CPU_HOG and
+ * CONFIG_TIMER_JITTER_UART_FLOOD. Both do nothing when their option is off.
+ */
+
+/* Start the load threads. */
+void load_start(void);
+
+/*
+ * Stop the load threads and wait until they are idle, so the UART is free
+ * for the report.
+ */
+void load_stop(void);
+
+#endif /* LOAD_H_ */
@@ -0,0 +1,124 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/uart.h>
+
+#include "load.h"
+
+#define LOAD_STACK_SIZE 1024
+
+/* time the CPU hog leaves interrupts unlocked between two locked spins */
+#define HOG_UNLOCK_US 10
+
+static atomic_t running;
+
+#ifdef CONFIG_TIMER_JITTER_CPU_HOG
+
+static K_SEM_DEFINE(hog_done, 0, 1);
+
+static void hog_main(void *p1, void *p2, void *p3)
+{
+	while (atomic_get(&running)) {
+#if CONFIG_TIMER_JITTER_CPU_HOG_LOCK_US > 0
+		unsigned int key = irq_lock();
+
+		k_busy_wait(CONFIG_TIMER_JITTER_CPU_HOG_LOCK_US);
+		irq_unlock(key);
+#endif
+		k_busy_wait(HOG_UNLOCK_US);
+	}
+
+	k_sem_give(&hog_done);
+}
+
+K_THREAD_DEFINE(hog_tid, LOAD_STACK_SIZE, hog_main, NULL, NULL, NULL,
+		CONFIG_TIMER_JITTER_CPU_HOG_PRIORITY, 0, SYS_FOREVER_MS);
+
+#endif /* CONFIG_TIMER_JITTER_CPU_HOG */
+
+#ifdef CONFIG_TIMER_JITTER_UART_FLOOD
+
+static const struct device *const flood_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_console));
+
+static const char flood_line[] =
+	"flood 0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ\r\n";
+
+/* next byte of flood_line to send, only used by the UART interrupt */
+static size_t flood_pos;
+static uint32_t flood_lines;
+
+static K_SEM_DEFINE(flood_sent, 0, 1);
+static K_SEM_DEFINE(flood_done, 0, 1);
+
+static void flood_cb(const struct device *dev, void *user_data)
+{
+	if (!uart_irq_update(dev) || !uart_irq_tx_ready(dev)) {
+		return;
+	}
+
+	flood_pos += uart_fifo_fill(dev, (const uint8_t *)&flood_line[flood_pos],
+				    sizeof(flood_line) - 1 - flood_pos);
+
+	if (flood_pos == sizeof(flood_line) - 1) {
+		uart_irq_tx_disable(dev);
+		k_sem_give(&flood_sent);
+	}
+}
+
+/* hand one line at a time to the TX interrupt and wait until it is sent */
+static void flood_main(void *p1, void *p2, void *p3)
+{
+	while (atomic_get(&running)) {
+		flood_pos = 0;
+		uart_irq_tx_enable(flood_dev);
+		k_sem_take(&flood_sent, K_FOREVER);
+		flood_lines++;
+	}
+
+	k_sem_give(&flood_done);
+}
+
+K_THREAD_DEFINE(flood_tid, LOAD_STACK_SIZE, flood_main, NULL, NULL, NULL,
+		CONFIG_TIMER_JITTER_UART_FLOOD_PRIORITY, 0, SYS_FOREVER_MS);
+
+#endif /* CONFIG_TIMER_JITTER_UART_FLOOD */
+
+void load_start(void)
+{
+	atomic_set(&running, 1);
+
+#ifdef CONFIG_TIMER_JITTER_CPU_HOG
+	k_thread_start(hog_tid);
+#endif
+
+#ifdef CONFIG_TIMER_JITTER_UART_FLOOD
+	if (!device_is_ready(flood_dev)) {
+		printk("UART device not found!\n");
+		k_sem_give(&flood_done);
+		return;
+	}
+
+	uart_irq_callback_user_data_set(flood_dev, flood_cb, NULL);
+	k_thread_start(flood_tid);
+#endif
+}
+
+void load_stop(void)
+{
+	atomic_set(&running, 0);
+
+#ifdef CONFIG_TIMER_JITTER_CPU_HOG
+	k_sem_take(&hog_done, K_FOREVER);
+	printk("cpu hog: interrupts locked for %u us at a time\n",
+	       CONFIG_TIMER_JITTER_CPU_HOG_LOCK_US);
+#endif
+
+#ifdef CONFIG_TIMER_JITTER_UART_FLOOD
+	k_sem_take(&flood_done, K_FOREVER);
+	printk("uart flood: %u lines of %u bytes\n", flood_lines,
+	       (uint32_t)sizeof(flood_line) - 1);
+#endif
+}
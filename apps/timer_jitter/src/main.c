@@ -0,0 +1,133 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+
+#include "lat_hist.h"
+#include "load.h"
+
+#define TIMERS CONFIG_TIMER_JITTER_TIMERS
+
+/*
+ * Eight buckets per power of two, so a percentile is at most 12.5 % above
+ * the true value, up to 2^24 cycles. Longer deviations share the last
+ * bucket; the exact maximum is kept anyway.
+ */
+#define JITTER_SUB_BITS 3
+#define JITTER_MAX_BITS 24
+#define JITTER_BUCKETS LAT_HIST_BUCKETS(JITTER_SUB_BITS, JITTER_MAX_BITS)
+
+struct jitter_timer {
+	struct k_timer timer;
+	uint32_t period_us;
+	/* period in cycles, after the kernel rounded it up to whole ticks */
+	uint32_t period_cyc;
+	/* cycle count the next expiry is due at, set by the first expiry */
+	uint32_t due;
+	bool anchored;
+	/* expiries that came before they were due */
+	uint32_t early;
+	/* cycles between due and actual expiry, either way */
+	struct lat_hist jitter;
+};
+
+static const uint32_t periods_us[] = {
+	CONFIG_TIMER_JITTER_PERIOD_1_US,
+	CONFIG_TIMER_JITTER_PERIOD_2_US,
+	CONFIG_TIMER_JITTER_PERIOD_3_US,
+	CONFIG_TIMER_JITTER_PERIOD_4_US,
+};
+
+BUILD_ASSERT(TIMERS <= ARRAY_SIZE(periods_us), "a period per timer is needed");
+
+static struct jitter_timer timers[TIMERS];
+static atomic_t jitter_buckets[TIMERS][JITTER_BUCKETS];
+
+/*
+ * Runs in the system timer interrupt. Expiries are compared against an
+ * absolute schedule anchored at the first one, so a late expiry does not
+ * move the ones after it and drift shows up as a growing deviation.
+ */
+static void expiry_func(struct k_timer *timer_id)
+{
+	struct jitter_timer *t = CONTAINER_OF(timer_id, struct jitter_timer, timer);
+	uint32_t now = k_cycle_get_32();
+	int32_t delta;
+
+	if (!t->anchored) {
+		t->due = now + t->period_cyc;
+		t->anchored = true;
+		return;
+	}
+
+	delta = (int32_t)(now - t->due);
+	t->due += t->period_cyc;
+
+	if (delta < 0) {
+		t->early++;
+		delta = -delta;
+	}
+
+	lat_hist_record(&t->jitter, (uint32_t)delta);
+}
+
+static void report(struct jitter_timer *t, int n)
+{
+	struct lat_hist_summary sum;
+	char name[8];
+
+	lat_hist_summary(&t->jitter, &sum);
+
+	/* the period actually run, after rounding to ticks */
+	printk("timer %d period %u us: n %u early %u | jitter us min %u avg %u "
+	       "p50 %u p90 %u p99 %u max %u\n",
+	       n, k_cyc_to_us_floor32(t->period_cyc), sum.count, t->early,
+	       k_cyc_to_us_floor32(sum.min), k_cyc_to_us_floor32(sum.mean),
+	       k_cyc_to_us_floor32(sum.p50), k_cyc_to_us_floor32(sum.p90),
+	       k_cyc_to_us_floor32(sum.p99), k_cyc_to_us_floor32(sum.max));
+
+	/* the raw histogram in cycles, for comparing runs on the host */
+	snprintk(name, sizeof(name), "t%d", n);
+	lat_hist_dump(&t->jitter, name);
+}
+
+int main(void)
+{
+	printk("timer_jitter: %d timers for %u ms, %u ticks/s, %u cycles/s\n",
+	       TIMERS, CONFIG_TIMER_JITTER_DURATION_MS, CONFIG_SYS_CLOCK_TICKS_PER_SEC,
+	       sys_clock_hw_cycles_per_sec());
+
+	for (int i = 0; i < TIMERS; i++) {
+		struct jitter_timer *t = &timers[i];
+
+		t->period_us = periods_us[i];
+		t->period_cyc = k_ticks_to_cyc_floor32(k_us_to_ticks_ceil32(t->period_us));
+		t->jitter = (struct lat_hist)LAT_HIST_INITIALIZER(
+			jitter_buckets[i], JITTER_SUB_BITS, JITTER_MAX_BITS);
+		k_timer_init(&t->timer, expiry_func, NULL);
+	}
+
+	load_start();
+
+	for (int i = 0; i < TIMERS; i++) {
+		k_timer_start(&timers[i].timer, K_USEC(timers[i].period_us),
+			      K_USEC(timers[i].period_us));
+	}
+
+	k_sleep(K_MSEC(CONFIG_TIMER_JITTER_DURATION_MS));
+
+	for (int i = 0; i < TIMERS; i++) {
+		k_timer_stop(&timers[i].timer);
+	}
+
+	load_stop();
+
+	for (int i = 0; i < TIMERS; i++) {
+		report(&timers[i], i + 1);
+	}
+
+	printk("timer_jitter done\n");
+	return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CMD_DISPATCHER_H_
+#define CMD_DISPATCHER_H_
+
+#include <zephyr/sys/iterable_sections.h>
+#include <zephyr/sys/util.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cmd_latency.h"
+#include "cmd_parser.h"
+
+struct cmd_desc;
+
+/*
+ * Reply to one request, collected while its handler runs and then sent as
+ * a whole, so that replies of concurrent requests never interleave. Every
+ * line starts with the request's sequence id ("#<seq> ").
+ */
+struct cmd_rsp {
+	uint32_t seq;
+	uint16_t len;
+	/* the next byte starts a new line and gets the id first */
+	bool line_start;
+	char buf[CONFIG_CMD_SERVER_RSP_SIZE];
+};
+
+/* Context of one command invocation, passed to its handler */
+struct cmd_ctx {
+	const struct cmd_desc *cmd;
+	const struct cmd_args *args;
+	/* reply being collected, or NULL to print straight to the UART */
+	struct cmd_rsp *rsp;
+};
+
+/*
+ * Command handler. argv[0] is the command name and argc has already been
+ * checked against the descriptor's limits. Returns 0 or a negative errno
+ * code.
+ */
+typedef int (*cmd_handler_t)(const struct cmd_ctx *ctx, int argc, char **argv);
+
+/*
+ * Scheduling class of a command, see cmd_pipeline.h. Urgent commands run
+ * ahead of any bulk work, so they must be short and must not block.
+ */
+enum cmd_class {
+	CMD_CLASS_URGENT,
+	CMD_CLASS_BULK,
+	CMD_CLASS_COUNT,
+};
+
+/* Command descriptor, placed in ROM by CMD_DEFINE() */
+struct cmd_desc {
+	const char *name;
+	cmd_handler_t handler;
+	const char *help;
+	/* limits on the number of arguments after the command name */
+	uint8_t min_args;
+	uint8_t max_args;
+	/* enum cmd_class */
+	uint8_t cls;
+#ifdef CONFIG_CMD_LATENCY
+	struct cmd_lat *lat;
+#endif
+};
+
+/*
+ * Register a command. _name must be a plain identifier and becomes the
+ * command word. The descriptor goes into the cmd_desc iterable section,
+ * which the linker sorts by name, so the dispatcher can binary-search the
+ * ROM table without any registration at run time. _class is the
+ * command's enum cmd_class.
+ *
+ * The linker actually sorts by the section name, which ends in
+ * "cmd_desc_<name>_". That is strcmp() order of the names unless one name
+ * is another followed by a digit or an uppercase letter, such as "led" and
+ * "led2": the '_' after "led" sorts after the '2'. Such pairs are not
+ * allowed; cmd_table_check() refuses them at startup.
+ */
+#define CMD_DEFINE(_name, _handler, _help, _min_args, _max_args, _class)	\
+	BUILD_ASSERT((_min_args) <= (_max_args) &&			\
+		     (_max_args) < CMD_ARGC_MAX,			\
+		     "invalid argument limits for command " #_name);	\
+	BUILD_ASSERT((_class) < CMD_CLASS_COUNT,			\
+		     "invalid class for command " #_name);		\
+	CMD_LAT_DEFINE(_name)						\
+	static const STRUCT_SECTION_ITERABLE(cmd_desc, UTIL_CAT(cmd_desc_, _name)) = { \
+		.name = STRINGIFY(_name),				\
+		.handler = _handler,					\
+		.help = _help,						\
+		.min_args = _min_args,					\
+		.max_args = _max_args,					\
+		.cls = _class,						\
+		CMD_LAT_INIT(_name)					\
+	}
+
+/*
+ * Check once that the command table is in strcmp() order of the names, as
+ * the lookups assume, and report the first pair that is not.
+ *
+ * Returns 0 or -EINVAL.
+ */
+int cmd_table_check(void);
+
+/* Look up a command by name. Returns NULL if there is none. */
+const struct cmd_desc *cmd_find(const char *name);
+
+/*
+ * Find the command of a parsed line and check its argument count. tag comes
+ * from cmd_stream_end(); unless it is CMD_STREAM_NONE, the line was already
+ * resolved while it was received. Unknown commands and wrong argument
+ * counts are reported to rsp, or straight to the UART if rsp is NULL.
+ *
+ * Returns 0 and sets *cmd, or a negative errno code.
+ */
+int cmd_resolve(struct cmd_args *args, uint16_t tag, struct cmd_rsp *rsp,
+		const struct cmd_desc **cmd);
+
+/* Run a resolved command. Returns the handler's result. */
+int cmd_run(const struct cmd_desc *cmd, struct cmd_args *args,
+	    struct cmd_rsp *rsp);
+
+/*
+ * Resolve and run the command named by args->argv[0] in one go.
+ *
+ * Returns the handler's result or a negative errno code.
+ */
+int cmd_dispatch(struct cmd_args *args, struct cmd_rsp *rsp);
+
+/* Start an empty reply for request seq. */
+void cmd_rsp_init(struct cmd_rsp *rsp, uint32_t seq);
+
+/*
+ * Finish a reply: a reply cut short by a full buffer still ends with a line
+ * end. Returns the number of bytes to send from rsp->buf.
+ */
+size_t cmd_rsp_finish(struct cmd_rsp *rsp);
+
+/* Print formatted command output to the context's reply or the UART. */
+void cmd_print(const struct cmd_ctx *ctx, const char *fmt, ...);
+
+#ifdef CONFIG_CMD_DISPATCH_BENCH
+/*
+ * Time linear, binary-search and perfect-hash lookup over synthetic
+ * command sets and print cycles per lookup.
+ */
+void cmd_dispatch_bench(void);
+#endif
+
+#endif /* CMD_DISPATCHER_H_ */
@@ -0,0 +1,125 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CMD_FRAME_H_
+#define CMD_FRAME_H_
+
+#include <zephyr/sys/iterable_sections.h>
+#include <zephyr/sys/util.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Binary frames, an alternative to text lines for high-rate clients:
+ *
+ *   cmd (1) | seq (1) | len (2, LE) | payload (len) | CRC-16 (2, LE)
+ *
+ * The CRC is CRC-16/CCITT as computed by crc16_ccitt() with seed 0 (also
+ * known as CRC-16/KERMIT) over header and payload. The whole frame is COBS
+ * encoded, so it contains no zero byte, and ends with a single 0x00, which
+ * makes every frame boundary unambiguous and lets a receiver resynchronise
+ * after garbage.
+ *
+ * A reply carries the request's cmd with CMD_FRAME_REPLY set and the same
+ * seq. Its payload starts with a status byte, 0 or a negative errno code,
+ * followed by up to CMD_FRAME_PAYLOAD_MAX bytes of the command's data.
+ */
+#define CMD_FRAME_HDR_SIZE 4
+#define CMD_FRAME_CRC_SIZE 2
+#define CMD_FRAME_REPLY 0x80
+
+/* largest payload of a request or reply, bounded by the RX ring's lines */
+#define CMD_FRAME_PAYLOAD_MAX \
+	(CONFIG_CMD_SERVER_LINE_MAX - CMD_FRAME_HDR_SIZE - CMD_FRAME_CRC_SIZE)
+
+/* bytes needed to COBS-encode n bytes, including the delimiter */
+#define CMD_FRAME_COBS_SIZE(n) ((n) + (n) / 254 + 2)
+
+/* line tag of a decoded frame in the RX ring, see cmd_stream.h */
+#define CMD_FRAME_TAG 0xFFFE
+
+/* binary command ids; scripts/cmd_client.py uses the same values */
+enum cmd_frame_id {
+	CMD_FRAME_PING = 0x01,
+	CMD_FRAME_TELEMETRY = 0x02,
+	CMD_FRAME_TEXT_MODE = 0x7F,
+};
+
+/*
+ * COBS decoder for the RX path, fed one byte at a time in interrupt
+ * context. It checks the CRC and the length as the frame passes, so the
+ * decoded bytes can go straight into the RX ring and the frame is only
+ * handed over if it is intact.
+ */
+struct cmd_frame_dec {
+	/* code byte of the current COBS group and bytes left in it */
+	uint8_t code;
+	uint8_t left;
+	/* decoded bytes so far and length from the header */
+	uint16_t len;
+	uint16_t payload_len;
+	uint16_t crc;
+};
+
+enum cmd_frame_rx {
+	/* nothing to do */
+	CMD_FRAME_RX_NONE,
+	/* *out holds the next decoded byte */
+	CMD_FRAME_RX_BYTE,
+	/* the frame is complete and intact */
+	CMD_FRAME_RX_END,
+	/* the frame ended but is corrupt, discard the decoded bytes */
+	CMD_FRAME_RX_BAD,
+};
+
+void cmd_frame_dec_reset(struct cmd_frame_dec *dec);
+enum cmd_frame_rx cmd_frame_dec_byte(struct cmd_frame_dec *dec, uint8_t in,
+				     uint8_t *out);
+
+/* Reply payload being built by a binary command handler */
+struct cmd_frame_rsp {
+	uint8_t buf[CMD_FRAME_PAYLOAD_MAX];
+	size_t len;
+};
+
+/* Append data to a reply. Returns 0 or -ENOMEM if it does not fit. */
+int cmd_frame_rsp_put(struct cmd_frame_rsp *rsp, const void *data, size_t len);
+int cmd_frame_rsp_put_le32(struct cmd_frame_rsp *rsp, uint32_t val);
+
+/*
+ * Binary command handler. req points to the request payload. Data for the
+ * reply is appended to rsp; the return value, 0 or a negative errno code,
+ * becomes its status byte.
+ */
+typedef int (*cmd_frame_handler_t)(const uint8_t *req, size_t len,
+				   struct cmd_frame_rsp *rsp);
+
+/* Binary command descriptor, placed in ROM by CMD_FRAME_DEFINE() */
+struct cmd_frame_desc {
+	uint8_t id;
+	cmd_frame_handler_t handler;
+};
+
+/*
+ * Register a binary command. Ids are few and dense, so the handful of
+ * descriptors is simply scanned.
+ */
+#define CMD_FRAME_DEFINE(_name, _id, _handler)					\
+	BUILD_ASSERT((_id) > 0 && (_id) < CMD_FRAME_REPLY,			\
+		     "invalid binary command id for " #_name);			\
+	static const STRUCT_SECTION_ITERABLE(cmd_frame_desc,			\
+					     UTIL_CAT(cmd_frame_desc_, _name)) = { \
+		.id = _id,							\
+		.handler = _handler,						\
+	}
+
+/*
+ * Run the command in a decoded frame from the RX ring and send the reply.
+ * Called from the main thread.
+ */
+void cmd_frame_handle(const uint8_t *frame, size_t len);
+
+#endif /* CMD_FRAME_H_ */
@@ -0,0 +1,103 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CMD_LATENCY_H_
+#define CMD_LATENCY_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include <stdint.h>
+
+#include "lat_hist.h"
+
+/*
+ * Latency probes along the path of a text command, enabled with
+ * CONFIG_CMD_LATENCY. Each probe takes k_cycle_get_32() at one stage:
+ */
+enum cmd_lat_stage {
+	/* entry of the UART interrupt that received the first byte */
+	CMD_LAT_ISR,
+	/* line end framed, the line is handed to the RX ring */
+	CMD_LAT_LINE,
+	/* line taken from the RX ring by the RX thread */
+	CMD_LAT_DEQUEUE,
+	/* handler called on its work queue */
+	CMD_LAT_DISPATCH,
+	/* handler returned, reply queued to the TX ring */
+	CMD_LAT_HANDLER,
+	/* last byte of the reply handed to the UART */
+	CMD_LAT_TX,
+	CMD_LAT_STAGES,
+};
+
+/*
+ * Intervals accumulated per command: one between each pair of consecutive
+ * stages, then the whole path from CMD_LAT_ISR to CMD_LAT_TX.
+ */
+#define CMD_LAT_SPANS CMD_LAT_STAGES
+#define CMD_LAT_SPAN_TOTAL (CMD_LAT_SPANS - 1)
+
+/*
+ * Histogram resolution: two buckets per power of two, so a percentile is
+ * at most 50 % above the true value, for intervals of up to 2^28 cycles.
+ */
+#define CMD_LAT_SUB_BITS 1
+#define CMD_LAT_MAX_BITS 28
+#define CMD_LAT_BUCKETS LAT_HIST_BUCKETS(CMD_LAT_SUB_BITS, CMD_LAT_MAX_BITS)
+
+/* Latency of one command, defined next to its descriptor by CMD_DEFINE() */
+struct cmd_lat {
+	struct lat_hist span[CMD_LAT_SPANS];
+	atomic_t bucket[CMD_LAT_SPANS][CMD_LAT_BUCKETS];
+};
+
+/* Stamps of one request, indexed by enum cmd_lat_stage */
+struct cmd_lat_stamps {
+	uint32_t t[CMD_LAT_STAGES];
+};
+
+#ifdef CONFIG_CMD_LATENCY
+
+#define CMD_LAT_STAMP(_stamps, _stage) ((_stamps)->t[_stage] = k_cycle_get_32())
+
+#define CMD_LAT_SPAN_INIT(_name, _span)					\
+	LAT_HIST_INITIALIZER(UTIL_CAT(cmd_lat_, _name).bucket[_span],	\
+			     CMD_LAT_SUB_BITS, CMD_LAT_MAX_BITS)
+
+/* used by CMD_DEFINE(), one initializer per span */
+#define CMD_LAT_DEFINE(_name)						\
+	static struct cmd_lat UTIL_CAT(cmd_lat_, _name) = {		\
+		.span = {						\
+			CMD_LAT_SPAN_INIT(_name, 0),			\
+			CMD_LAT_SPAN_INIT(_name, 1),			\
+			CMD_LAT_SPAN_INIT(_name, 2),			\
+			CMD_LAT_SPAN_INIT(_name, 3),			\
+			CMD_LAT_SPAN_INIT(_name, 4),			\
+			CMD_LAT_SPAN_INIT(_name, 5),			\
+		},							\
+	};
+#define CMD_LAT_INIT(_name) .lat = &UTIL_CAT(cmd_lat_, _name),
+
+/*
+ * Hand over the stamps of a request whose reply ends at TX stream position
+ * mark (see print_uartv()). They are added to the command's histograms
+ * once the TX drain has passed the mark. Only a few replies can be tracked
+ * at a time; beyond that the sample is lost.
+ */
+void cmd_lat_tx_queued(struct cmd_lat *lat, const struct cmd_lat_stamps *stamps,
+		       uint32_t mark);
+
+/* Called by the TX drain with the number of bytes handed to the UART. */
+void cmd_lat_tx_sent(uint32_t sent);
+
+#else
+
+#define CMD_LAT_STAMP(_stamps, _stage) do { } while (false)
+#define CMD_LAT_DEFINE(_name)
+#define CMD_LAT_INIT(_name)
+
+#endif /* CONFIG_CMD_LATENCY */
+
+#endif /* CMD_LATENCY_H_ */
@@ -0,0 +1,66 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CMD_PARSER_H_
+#define CMD_PARSER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* most arguments in a command line, including the command name */
+#define CMD_ARGC_MAX CONFIG_CMD_SERVER_ARGC_MAX
+
+/* where a token came from in the received line, for error messages */
+struct cmd_span {
+	uint16_t start;
+	uint16_t len;
+};
+
+/*
+ * Tokens of a parsed command line. argv points into the line itself and is
+ * NULL-terminated; span[i] covers argv[i] in the line as received,
+ * including quotes and escapes.
+ */
+struct cmd_args {
+	int argc;
+	char *argv[CMD_ARGC_MAX + 1];
+	struct cmd_span span[CMD_ARGC_MAX];
+};
+
+enum cmd_parse_error {
+	CMD_PARSE_OK = 0,
+	/* more than CMD_ARGC_MAX tokens */
+	CMD_PARSE_TOO_MANY_ARGS,
+	/* a quote is not closed before the end of the line */
+	CMD_PARSE_OPEN_QUOTE,
+	/* the line ends with a backslash */
+	CMD_PARSE_TRAILING_ESCAPE,
+};
+
+/*
+ * Split line into whitespace-separated tokens in place: token ends are
+ * overwritten with NUL and escapes are resolved by moving the rest of the
+ * token down, so nothing is copied or allocated. line[len] must be NUL.
+ *
+ * Single quotes keep everything up to the closing quote literally. Double
+ * quotes group words but still resolve backslash escapes. Outside single
+ * quotes, a backslash makes the next character literal, except for \n, \r
+ * and \t, which produce the control characters. Quoted and unquoted parts
+ * next to each other form one token.
+ *
+ * On error, err_span (if not NULL) is set to the offending part of the line
+ * and the contents of args are undefined.
+ */
+enum cmd_parse_error cmd_parse(char *line, size_t len, struct cmd_args *args,
+			       struct cmd_span *err_span);
+
+/* Short description of a parse error. */
+const char *cmd_parse_strerror(enum cmd_parse_error err);
+
+#ifdef CONFIG_CMD_PARSER_BENCH
+/* Time cmd_parse() on sample lines and print cycles per token. */
+void cmd_parser_bench(void);
+#endif
+
+#endif /* CMD_PARSER_H_ */
@@ -0,0 +1,73 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CMD_PHASH_H_
+#define CMD_PHASH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Minimal perfect hash over a fixed set of names, generated at build time by
+ * scripts/gen_cmd_hash.py. The name's hash selects a bucket, the bucket's
+ * seed displaces the hash onto one of count slots, and each slot holds the
+ * index of the only name that can be there. A lookup is one pass over the
+ * name and one comparison, whatever the number of names.
+ *
+ * The hash functions below must match the generator.
+ */
+struct cmd_phash {
+	uint16_t count;
+	uint16_t buckets;
+	/* per bucket */
+	const uint16_t *seed;
+	/* per slot: index of the name and its length */
+	const uint16_t *index;
+	const uint8_t *len;
+};
+
+/* FNV-1a over a NUL-terminated name, storing its length in len */
+static inline uint32_t cmd_phash_str(const char *name, size_t *len)
+{
+	uint32_t h = 0x811C9DC5U;
+	const char *p = name;
+
+	while (*p != '\0') {
+		h = (h ^ (uint8_t)*p++) * 0x01000193U;
+	}
+	*len = p - name;
+
+	return h;
+}
+
+/* finalizer spreading all bits of h before it is reduced */
+static inline uint32_t cmd_phash_mix(uint32_t h)
+{
+	h ^= h >> 16;
+	h *= 0x85EBCA6BU;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35U;
+	h ^= h >> 16;
+
+	return h;
+}
+
+/* h scaled to [0, n) by a multiply instead of a division */
+static inline uint32_t cmd_phash_reduce(uint32_t h, uint32_t n)
+{
+	return (uint32_t)(((uint64_t)h * n) >> 32);
+}
+
+/*
+ * Slot for a name with hash h. Only the name at ph->index[slot] can match;
+ * the caller compares against it, checking ph->len[slot] first.
+ */
+static inline uint32_t cmd_phash_slot(const struct cmd_phash *ph, uint32_t h)
+{
+	uint32_t seed = ph->seed[cmd_phash_reduce(cmd_phash_mix(h), ph->buckets)];
+
+	return cmd_phash_reduce(cmd_phash_mix(h ^ (seed * 0x9E3779B9U)), ph->count);
+}
+
+#endif /* CMD_PHASH_H_ */
@@ -0,0 +1,51 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CMD_PIPELINE_H_
+#define CMD_PIPELINE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "line_ring.h"
+
+/*
+ * Request pipeline between the RX thread and the work queues that run the
+ * command handlers.
+ *
+ * The RX thread wraps each line in a request, gives it the next sequence
+ * id, parses it in place in the RX ring and resolves its command, then
+ * queues it on the lane of the command's class:
+ *
+ * - CMD_CLASS_URGENT commands run on the system workqueue, which has a
+ *   cooperative priority by default and so takes the CPU from any bulk
+ *   handler as soon as an urgent request is queued.
+ * - CMD_CLASS_BULK commands run on CONFIG_CMD_SERVER_WORKERS work queues of
+ *   their own, started with k_work_queue_start(); each request goes to the
+ *   queue with the least work, so a slow command only occupies one.
+ *
+ * Each reply is collected in its request and queued to the UART in one
+ * piece as soon as its handler returns, and the line goes back to the RX
+ * ring. Every reply line carries the id of its request ("#<seq> ") so that
+ * clients can match replies that arrive out of order.
+ *
+ * At most CONFIG_CMD_SERVER_PIPELINE_DEPTH requests are in flight, and bulk
+ * requests never take the last of them. Bulk requests beyond that wait in
+ * a backlog of CONFIG_CMD_SERVER_BULK_BACKLOG requests with blocks of their
+ * own, and are answered with a busy error once it is full. The RX thread
+ * therefore never waits for bulk work, and an urgent command such as stop
+ * is always accepted behind it; it only waits for a block while urgent
+ * requests fill the last slot. The queues command shows the depth, busy
+ * count and wait time of each class.
+ */
+void cmd_pipeline_init(struct line_ring *ring);
+
+/*
+ * Submit a line returned by line_ring_get() from ring, with its tag from
+ * the stream resolver. The request takes the line over and releases it
+ * once it is answered. Called from the RX thread only.
+ */
+void cmd_pipeline_submit(char *line, size_t len, uint16_t tag);
+
+#endif /* CMD_PIPELINE_H_ */
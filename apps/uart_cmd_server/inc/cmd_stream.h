@@ -0,0 +1,57 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CMD_STREAM_H_
+#define CMD_STREAM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Line tags produced by cmd_stream_end() and stored with each line in the
+ * RX ring. Any other value is the index of the command in the cmd_desc
+ * section plus one, with the argument count already checked.
+ */
+/* nothing is known about the line, look the command up */
+#define CMD_STREAM_NONE 0
+/* the line is well-formed but its first word names no command */
+#define CMD_STREAM_UNKNOWN 0xFFFF
+/* 0xFFFE is CMD_FRAME_TAG, a binary frame */
+
+/*
+ * Byte-driven command resolver, fed by the RX framer while the line is still
+ * arriving. Command names are sorted, so the names starting with the bytes
+ * seen so far form one range of the table; each byte of the first word
+ * narrows that range, and the command is known as soon as the word ends.
+ * The rest of the line is followed with the quoting rules of cmd_parse() to
+ * count the arguments, so by the time the line end arrives only the
+ * handler's own work is left for the main thread.
+ *
+ * A first word with quotes or escapes is left to the regular lookup, and so
+ * is any line cmd_parse() would reject, which then reports the error.
+ */
+struct cmd_stream {
+	uint8_t state;
+	/* open quote and pending backslash in the current argument */
+	char quote;
+	bool escape;
+	/* tokens so far, including the command name */
+	uint8_t argc;
+	/* commands whose names start with the first word seen so far */
+	uint16_t lo;
+	uint16_t hi;
+	uint16_t depth;
+	/* resolved command, or -1 if the first word names none */
+	int16_t cmd;
+};
+
+void cmd_stream_reset(struct cmd_stream *s);
+
+/* Feed the next byte of the line; line ends are not passed in. */
+void cmd_stream_feed(struct cmd_stream *s, char c);
+
+/* End the line and return its tag. The resolver is ready for the next line. */
+uint16_t cmd_stream_end(struct cmd_stream *s);
+
+#endif /* CMD_STREAM_H_ */
@@ -0,0 +1,144 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LINE_RING_H_
+#define LINE_RING_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/byteorder.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* size of the ring in bytes, must be a power of two */
+#define LINE_RING_SIZE CONFIG_CMD_SERVER_RX_RING_SIZE
+
+/* longest line accepted; longer lines are dropped */
+#define LINE_RING_LINE_MAX CONFIG_CMD_SERVER_LINE_MAX
+
+#ifdef CONFIG_CMD_LATENCY
+/* cycle stamps of the first byte's interrupt and of the line end */
+#define LINE_RING_STAMP_SIZE 8
+#else
+#define LINE_RING_STAMP_SIZE 0
+#endif
+
+/* length, tag and stamps in front of every line */
+#define LINE_RING_HDR_SIZE (4 + LINE_RING_STAMP_SIZE)
+
+/*
+ * Single-producer byte ring holding variable-length lines.
+ *
+ * Each line is stored as a 2-byte little-endian length and a 2-byte tag
+ * followed by the line and a NUL terminator, packed back to back, so a
+ * short line only takes the room it needs. The producer (UART ISR) appends
+ * bytes to the open line and fills in its length and tag on commit; the
+ * consumer (main thread) gets a pointer to the next complete line inside
+ * the ring and parses it there. The tag is opaque to the ring and carries
+ * what the producer already learnt about the line. With CONFIG_CMD_LATENCY
+ * the header also carries two cycle stamps for the latency probes.
+ *
+ * Lines stay in the ring until they are released, which may happen in any
+ * order and from any thread: a released line is marked in its header, and
+ * the room is given back to the producer up to the oldest line still held.
+ *
+ * A line never wraps around the end of the buffer, so the consumer always
+ * sees it as one contiguous string. If the open line reaches the end, the
+ * producer moves it to the start and marks the vacated length prefix with
+ * LINE_RING_WRAP; if there is no room for a length prefix at all, both
+ * sides skip to the start on their own.
+ *
+ * Only head/line_start are written by the producer and only tail by the
+ * consumer side, so no lock is needed between them; release_lock only
+ * orders the consumer's get and releases among themselves. The semaphore
+ * counts complete lines and doubles as the consumer wakeup.
+ */
+struct line_ring {
+	char buf[LINE_RING_SIZE];
+	/* producer: next free byte and length prefix of the open line */
+	uint32_t head;
+	uint32_t line_start;
+	/* producer: open line cannot be stored, drop it up to the next EOL */
+	bool discard;
+#ifdef CONFIG_CMD_LATENCY
+	/* producer: interrupt entry that received the open line's first byte */
+	uint32_t stamp_isr;
+#endif
+	/* consumer: where line_ring_get() finds the next line */
+	uint32_t read;
+	/* first byte still in use by the consumer */
+	atomic_t tail;
+	struct k_spinlock release_lock;
+	/* lines lost because the ring was full or they were too long */
+	atomic_t dropped;
+	struct k_sem lines;
+};
+
+void line_ring_init(struct line_ring *ring);
+
+/*
+ * Producer side, call from one producer context at a time.
+ *
+ * line_ring_put() appends a byte to the open line; a line longer than
+ * LINE_RING_LINE_MAX is dropped as a whole. line_ring_commit() terminates
+ * the open line, stores tag with it and hands it to the consumer; empty
+ * lines are ignored. line_ring_abort() throws the open line away without
+ * counting it as dropped, for producers that validate their input.
+ */
+void line_ring_put(struct line_ring *ring, char c);
+void line_ring_commit(struct line_ring *ring, uint16_t tag);
+void line_ring_abort(struct line_ring *ring);
+
+/*
+ * Consumer side.
+ *
+ * line_ring_get() waits for the next complete line and returns a pointer to
+ * it inside the ring, or NULL on timeout, and stores its length in len and
+ * its tag in tag. Call it from a single thread. The line is NUL-terminated,
+ * may be modified in place and stays valid until it is passed to
+ * line_ring_release(), which any thread may do, in any order. A line held
+ * for long keeps the room of every later line from being reused.
+ */
+char *line_ring_get(struct line_ring *ring, size_t *len, uint16_t *tag,
+		    k_timeout_t timeout);
+void line_ring_release(struct line_ring *ring, char *line);
+
+/* true while the producer holds a partial line */
+static inline bool line_ring_is_open(const struct line_ring *ring)
+{
+	return ring->head != ring->line_start || ring->discard;
+}
+
+#ifdef CONFIG_CMD_LATENCY
+/*
+ * Producer: bytes put from now on were received by an interrupt entered at
+ * cycle count cyc. Only the stamp of the first byte of a line is kept.
+ */
+static inline void line_ring_stamp_isr(struct line_ring *ring, uint32_t cyc)
+{
+	if (!line_ring_is_open(ring)) {
+		ring->stamp_isr = cyc;
+	}
+}
+
+/*
+ * Consumer: stamps of a line returned by line_ring_get(), which are stored
+ * in the header right in front of it. The header never wraps.
+ */
+static inline void line_ring_stamps(const char *line, uint32_t *isr,
+				    uint32_t *end)
+{
+	*isr = sys_get_le32((const uint8_t *)line - 8);
+	*end = sys_get_le32((const uint8_t *)line - 4);
+}
+#endif
+
+static inline uint32_t line_ring_dropped(struct line_ring *ring)
+{
+	return (uint32_t)atomic_get(&ring->dropped);
+}
+
+#endif /* LINE_RING_H_ */
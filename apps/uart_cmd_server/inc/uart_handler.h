@@ -0,0 +1,82 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef UART_HANDLER_H_
+#define UART_HANDLER_H_
+
+#include "line_ring.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* one fragment of a reply passed to uart_writev() */
+struct uart_iov {
+	const void *base;
+	size_t len;
+};
+
+/*
+ * Start receiving on the command UART. Received lines are framed into ring,
+ * using the asynchronous UART API if CONFIG_CMD_SERVER_UART_ASYNC is set and
+ * the interrupt-driven API otherwise.
+ *
+ * Returns 0 on success or a negative errno code.
+ */
+int uart_handler_init(struct line_ring *ring);
+
+/*
+ * Switch reception between text lines and binary frames (see cmd_frame.h)
+ * with CONFIG_CMD_SERVER_BINARY. The framer switches before the next byte
+ * it receives that does not continue a partial line or frame, so the peer
+ * must wait for the reply confirming the switch before it changes format.
+ */
+void uart_handler_set_binary(bool binary);
+
+/*
+ * Queue up to len bytes for transmission without blocking. The data is sent
+ * from the TX interrupt, or by uart_tx() in asynchronous mode.
+ *
+ * If done is not NULL it is given once all accepted bytes have been handed
+ * to the UART. Only a few completions can be pending at a time; -EBUSY is
+ * returned without queueing anything if none is free.
+ *
+ * Returns the number of bytes accepted, which is less than len if the TX
+ * ring is full, or a negative errno code.
+ */
+int uart_write(const void *buf, size_t len, struct k_sem *done);
+
+/*
+ * Queue all fragments of iov as one contiguous transmission without
+ * blocking and without concatenating them first. Either every fragment is
+ * queued or none: -EAGAIN is returned if the TX ring does not have room for
+ * all of them yet (or no completion is free while done is given), and
+ * -EMSGSIZE if they could never fit.
+ *
+ * Returns the total number of bytes queued or a negative errno code.
+ */
+int uart_writev(const struct uart_iov *iov, size_t iovcnt, struct k_sem *done);
+
+/*
+ * Queue a null-terminated string for transmission, waiting only while the
+ * TX ring is full.
+ */
+void print_uart(const char *buf);
+
+/*
+ * Queue the fragments of iov as one transmission, waiting only until the
+ * TX ring has room for all of them.
+ *
+ * If mark is not NULL it is set to the position in the TX stream, counted
+ * in bytes since startup, right after the transmission; it has been sent
+ * once uart_tx_sent() has passed it.
+ *
+ * Returns 0, or -EMSGSIZE without queueing anything if the fragments
+ * together are larger than the TX ring.
+ */
+int print_uartv(const struct uart_iov *iov, size_t iovcnt, uint32_t *mark);
+
+/* Bytes handed to the UART since startup; wraps around. */
+uint32_t uart_tx_sent(void);
+
+#endif /* UART_HANDLER_H_ */
@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: Apache-2.0
+
+"""Host client for the binary frame mode of uart_cmd_server.
+
+Talks to the board's UART or to QEMU's serial pty, switches the server to
+binary frames with the 'binary' text command and then sends COBS-framed
+requests (see inc/cmd_frame.h for the format):
+
+    cmd_client.py /dev/pts/3 ping hello
+    cmd_client.py /dev/pts/3 telemetry --count 1000
+    cmd_client.py /dev/pts/3 text
+
+Only the Python standard library is used, so any pty or tty works without
+pyserial.
+"""
+
+import argparse
+import os
+import select
+import struct
+import sys
+import termios
+import time
+import tty
+
+# command ids, as in enum cmd_frame_id
+CMD_PING = 0x01
+CMD_TELEMETRY = 0x02
+CMD_TEXT_MODE = 0x7F
+CMD_REPLY = 0x80
+
+HDR = struct.Struct('<BBH')
+
+
+def crc16_ccitt(data, crc=0):
+    """CRC-16/CCITT as Zephyr's crc16_ccitt(): reflected, no final XOR."""
+    for b in data:
+        e = (crc ^ b) & 0xFF
+        f = (e ^ (e << 4)) & 0xFF
+        crc = (crc >> 8) ^ (f << 8) ^ (f << 3) ^ (f >> 4)
+    return crc & 0xFFFF
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_pos = 0
+    code = 1
+    for b in data:
+        if b != 0:
+            out.append(b)
+            code += 1
+        if b == 0 or code == 0xFF:
+            out[code_pos] = code
+            code_pos = len(out)
+            out.append(0)
+            code = 1
+    out[code_pos] = code
+    out.append(0)
+    return bytes(out)
+
+
+def cobs_decode(data):
+    """Decode one frame without its delimiter; None if it is malformed."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def build_frame(cmd, seq, payload=b''):
+    body = HDR.pack(cmd, seq, len(payload)) + payload
+    return cobs_encode(body + struct.pack('<H', crc16_ccitt(body)))
+
+
+def parse_frame(encoded):
+    """Return (cmd, seq, status, data) of a reply, or None if corrupt."""
+    body = cobs_decode(encoded)
+    if body is None or len(body) < HDR.size + 3 or crc16_ccitt(body) != 0:
+        return None
+    cmd, seq, length = HDR.unpack_from(body)
+    payload = body[HDR.size:-2]
+    if length != len(payload) or length < 1:
+        return None
+    status = struct.unpack_from('<b', payload)[0]
+    return cmd, seq, status, payload[1:]
+
+
+class Link:
+    def __init__(self, path):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        if os.isatty(self.fd):
+            tty.setraw(self.fd)
+            attrs = termios.tcgetattr(self.fd)
+            attrs[4] = attrs[5] = termios.B115200
+            termios.tcsetattr(self.fd, termios.TCSANOW, attrs)
+        self.rx = bytearray()
+
+    def write(self, data):
+        os.write(self.fd, data)
+
+    def read_until(self, delim, timeout):
+        deadline = time.monotonic() + timeout
+        while delim not in self.rx:
+            left = deadline - time.monotonic()
+            if left <= 0 or not select.select([self.fd], [], [], left)[0]:
+                raise TimeoutError('no reply')
+            self.rx += os.read(self.fd, 4096)
+        end = self.rx.index(delim) + len(delim)
+        data = bytes(self.rx[:end])
+        del self.rx[:end]
+        return data
+
+    def text_command(self, line, expect, timeout=2.0):
+        self.write(line.encode() + b'\r\n')
+        while True:
+            reply = self.read_until(b'\n', timeout)
+            if expect in reply:
+                return
+
+    def request(self, cmd, seq, payload=b'', timeout=2.0):
+        self.write(build_frame(cmd, seq, payload))
+        while True:
+            encoded = self.read_until(b'\0', timeout)[:-1]
+            if not encoded:
+                continue
+            reply = parse_frame(encoded)
+            if reply is None:
+                print('corrupt reply frame', file=sys.stderr)
+                continue
+            if reply[0] == cmd | CMD_REPLY and reply[1] == seq:
+                return reply[2], reply[3]
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument('port', help='serial device or QEMU pty')
+    parser.add_argument('command', choices=['ping', 'telemetry', 'text'])
+    parser.add_argument('payload', nargs='?', default='',
+                        help='ping payload')
+    parser.add_argument('--count', type=int, default=1,
+                        help='number of requests to send')
+    parser.add_argument('--no-switch', action='store_true',
+                        help='server is already in binary mode')
+    args = parser.parse_args()
+
+    link = Link(args.port)
+    if not args.no_switch:
+        link.text_command('binary', b'OK binary')
+
+    cmd = {'ping': CMD_PING, 'telemetry': CMD_TELEMETRY,
+           'text': CMD_TEXT_MODE}[args.command]
+    start = time.monotonic()
+
+    for n in range(args.count):
+        status, data = link.request(cmd, n & 0xFF, args.payload.encode())
+        if status != 0:
+            print('request failed: {}'.format(os.strerror(-status)))
+            return 1
+        if args.count == 1 or n == args.count - 1:
+            if cmd == CMD_TELEMETRY:
+                uptime, cycles, ok, bad = struct.unpack('<IIII', data)
+                print('uptime {} ms, cycles {}, frames ok {}, bad {}'.format(
+                    uptime, cycles, ok, bad))
+            elif cmd == CMD_PING:
+                print('ping: {!r}'.format(data))
+            else:
+                print('server is back in text mode')
+
+    if args.count > 1:
+        elapsed = time.monotonic() - start
+        print('{} requests in {:.3f} s, {:.0f} per second'.format(
+            args.count, elapsed, args.count / elapsed))
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
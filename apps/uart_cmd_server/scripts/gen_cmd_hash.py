@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: Apache-2.0
+
+"""Generate a minimal perfect hash over command names.
+
+In the default mode the command names registered with CMD_DEFINE() are
+collected from the given source files and a table for cmd_dispatcher.c is
+written. Slots map to indices into the cmd_desc section, which the linker
+sorts by section name, so the names are sorted the same way here. The
+dispatcher needs that order to be strcmp() order of the names as well,
+which is checked here at build time.
+
+With --bench, tables over synthetic command sets of the given sizes are
+written instead, for the dispatch benchmark.
+
+The hash functions must match inc/cmd_phash.h.
+"""
+
+import argparse
+import random
+import re
+import sys
+
+MASK = 0xFFFFFFFF
+SEED_MAX = 0xFFFF
+
+# CMD_DEFINE() at the start of a line, as used by the command sources
+CMD_DEFINE_RE = re.compile(r'^\s*CMD_DEFINE\(\s*([A-Za-z_][A-Za-z0-9_]*)\s*,',
+                           re.MULTILINE)
+
+
+def fnv1a(name):
+    h = 0x811C9DC5
+    for c in name.encode():
+        h = ((h ^ c) * 0x01000193) & MASK
+    return h
+
+
+def mix(h):
+    h ^= h >> 16
+    h = (h * 0x85EBCA6B) & MASK
+    h ^= h >> 13
+    h = (h * 0xC2B2AE35) & MASK
+    h ^= h >> 16
+    return h
+
+
+def reduce(h, n):
+    return (h * n) >> 32
+
+
+def slot_of(h, seed, count):
+    return reduce(mix(h ^ ((seed * 0x9E3779B9) & MASK)), count)
+
+
+def build(names):
+    """Return (buckets, seeds, index) for sorted, unique names.
+
+    Hash and displace: keys are spread over buckets by one hash, then the
+    buckets are placed largest first, each with the first seed that moves
+    all of its keys to free slots.
+    """
+    count = len(names)
+    hashes = [fnv1a(n) for n in names]
+    if len(set(hashes)) != count:
+        sys.exit('gen_cmd_hash: command names collide in the base hash')
+
+    nbuckets = max(1, (count + 2) // 3)
+    buckets = [[] for _ in range(nbuckets)]
+    for i, h in enumerate(hashes):
+        buckets[reduce(mix(h), nbuckets)].append(i)
+
+    seeds = [0] * nbuckets
+    index = [None] * count
+    for b in sorted(range(nbuckets), key=lambda b: -len(buckets[b])):
+        if not buckets[b]:
+            break
+        for seed in range(SEED_MAX + 1):
+            slots = {slot_of(hashes[i], seed, count) for i in buckets[b]}
+            if len(slots) == len(buckets[b]) and \
+               all(index[s] is None for s in slots):
+                break
+        else:
+            sys.exit('gen_cmd_hash: no seed found, too many commands')
+        seeds[b] = seed
+        for i in buckets[b]:
+            index[slot_of(hashes[i], seed, count)] = i
+
+    return nbuckets, seeds, index
+
+
+def section_key(name):
+    """Sort key of a descriptor in the linker-sorted cmd_desc section."""
+    return (name + '_').encode()
+
+
+def c_array(ctype, name, values):
+    lines = []
+    for i in range(0, len(values), 8):
+        lines.append('\t' + ', '.join(str(v) for v in values[i:i + 8]) + ',')
+    return 'static const {} {}[] = {{\n{}\n}};\n'.format(
+        ctype, name, '\n'.join(lines))
+
+
+def emit_table(prefix, names):
+    nbuckets, seeds, index = build(names)
+    lens = [len(names[i]) for i in index]
+    return ''.join([
+        c_array('uint16_t', prefix + '_seed', seeds),
+        c_array('uint16_t', prefix + '_index', index),
+        c_array('uint8_t', prefix + '_len', lens),
+        '\nstatic const struct cmd_phash {} = {{\n'.format(prefix),
+        '\t.count = {},\n'.format(len(names)),
+        '\t.buckets = {},\n'.format(nbuckets),
+        '\t.seed = {0}_seed,\n\t.index = {0}_index,\n\t.len = {0}_len,\n'
+        .format(prefix),
+        '};\n',
+    ])
+
+
+def synthetic_names(count):
+    """Command-like words, reproducible between builds."""
+    rng = random.Random(count)
+    names = set()
+    while len(names) < count:
+        names.add(''.join(rng.choice('abcdefghijklmnopqrstuvwxyz')
+                          for _ in range(rng.randint(3, 10))))
+    return sorted(names)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('-o', '--output', required=True)
+    parser.add_argument('--bench', metavar='SIZES',
+                        help='comma-separated synthetic command counts')
+    parser.add_argument('sources', nargs='*')
+    args = parser.parse_args()
+
+    out = ['/* Generated by gen_cmd_hash.py, do not edit. */\n\n',
+           '#include "cmd_phash.h"\n\n']
+
+    if args.bench:
+        for count in (int(s) for s in args.bench.split(',')):
+            names = synthetic_names(count)
+            out.append('static const char *const bench_names_{}[] = {{\n'
+                       .format(count))
+            out.extend('\t"{}",\n'.format(n) for n in names)
+            out.append('};\n\n')
+            out.append(emit_table('bench_hash_{}'.format(count), names))
+            out.append('\n')
+        out.append('#define BENCH_SIZES(fn) {}\n'.format(
+            ' '.join('fn({})'.format(s) for s in args.bench.split(','))))
+    else:
+        names = set()
+        for path in args.sources:
+            with open(path, encoding='utf-8') as f:
+                names.update(CMD_DEFINE_RE.findall(f.read()))
+        if not names:
+            sys.exit('gen_cmd_hash: no CMD_DEFINE() found')
+        for name in names:
+            if len(name) > 255:
+                sys.exit('gen_cmd_hash: command name too long: ' + name)
+        # the linker sorts by the section name, "cmd_desc_<name>_"
+        names = sorted(names, key=section_key)
+        for a, b in zip(names, names[1:]):
+            if a.encode() > b.encode():
+                sys.exit('gen_cmd_hash: commands {} and {} do not sort the '
+                         'same by name and by section, see CMD_DEFINE()'
+                         .format(a, b))
+        out.append('/* commands, in section order */\n')
+        out.extend('/*   {:3d} {} */\n'.format(i, n) for i, n in enumerate(names))
+        out.append('\n#define CMD_HASH_COUNT {}\n\n'.format(len(names)))
+        out.append(emit_table('cmd_hash_table', names))
+
+    with open(args.output, 'w', encoding='utf-8') as f:
+        f.write(''.join(out))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,111 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+
+#include <string.h>
+
+#include "cmd_dispatcher.h"
+
+/* generated by scripts/gen_cmd_hash.py --bench: names and hash per size */
+#include "cmd_bench_tables.h"
+
+/* lookups timed per method and size, spread over all names */
+#define BENCH_LOOKUPS 5000
+
+typedef int (*bench_find_t)(const char *const *names, const struct cmd_phash *ph,
+			    int count, const char *name);
+
+/* strcmp() chain, as a hand-written dispatcher would do it */
+static int find_linear(const char *const *names, const struct cmd_phash *ph,
+		       int count, const char *name)
+{
+	ARG_UNUSED(ph);
+
+	for (int i = 0; i < count; i++) {
+		if (strcmp(name, names[i]) == 0) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/* same search as cmd_find() with CONFIG_CMD_LOOKUP_BSEARCH */
+static int find_bsearch(const char *const *names, const struct cmd_phash *ph,
+			int count, const char *name)
+{
+	int lo = 0;
+	int hi = count - 1;
+
+	ARG_UNUSED(ph);
+
+	while (lo <= hi) {
+		int mid = lo + (hi - lo) / 2;
+		int cmp = strcmp(name, names[mid]);
+
+		if (cmp == 0) {
+			return mid;
+		} else if (cmp < 0) {
+			hi = mid - 1;
+		} else {
+			lo = mid + 1;
+		}
+	}
+
+	return -1;
+}
+
+/* same lookup as cmd_find() with CONFIG_CMD_LOOKUP_PHASH */
+static int find_phash(const char *const *names, const struct cmd_phash *ph,
+		      int count, const char *name)
+{
+	size_t len;
+	uint32_t slot = cmd_phash_slot(ph, cmd_phash_str(name, &len));
+	int i = ph->index[slot];
+
+	ARG_UNUSED(count);
+
+	if (len != ph->len[slot] || memcmp(name, names[i], len) != 0) {
+		return -1;
+	}
+
+	return i;
+}
+
+/* average cycles per lookup when looking up every name in turn */
+static uint32_t bench_run(bench_find_t find, const char *const *names,
+			  const struct cmd_phash *ph, int count)
+{
+	int rounds = DIV_ROUND_UP(BENCH_LOOKUPS, count);
+	uint32_t start;
+	uint32_t elapsed;
+
+	start = k_cycle_get_32();
+	for (int r = 0; r < rounds; r++) {
+		for (int i = 0; i < count; i++) {
+			if (find(names, ph, count, names[i]) != i) {
+				printk("lookup of '%s' failed\n", names[i]);
+				return 0;
+			}
+		}
+	}
+	elapsed = k_cycle_get_32() - start;
+
+	return elapsed / (rounds * count);
+}
+
+#define BENCH_SIZE(n)								\
+	printk("%4d commands %8u %8u %8u\n", n,					\
+	       bench_run(find_linear, bench_names_##n, &bench_hash_##n, n),	\
+	       bench_run(find_bsearch, bench_names_##n, &bench_hash_##n, n),	\
+	       bench_run(find_phash, bench_names_##n, &bench_hash_##n, n));
+
+void cmd_dispatch_bench(void)
+{
+	printk("Command lookup benchmark, cycles per lookup\n");
+	printk("%13s %8s %8s %8s\n", "", "linear", "bsearch", "phash");
+
+	BENCH_SIZES(BENCH_SIZE)
+}
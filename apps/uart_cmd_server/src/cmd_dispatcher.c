@@ -0,0 +1,255 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+
+#include <stdarg.h>
+#include <string.h>
+
+#include "cmd_dispatcher.h"
+#include "cmd_stream.h"
+#include "uart_handler.h"
+
+#ifdef CONFIG_CMD_LOOKUP_PHASH
+/* generated by scripts/gen_cmd_hash.py from the CMD_DEFINE() lines */
+#include "cmd_hash_table.h"
+#endif
+
+/* longest single piece of output written by cmd_print() */
+#define CMD_PRINT_MAX 128
+
+/*
+ * Binary search of the descriptors, which the linker sorted by name, as
+ * checked by cmd_table_check().
+ */
+static const struct cmd_desc *cmd_bsearch(const char *name)
+{
+	const struct cmd_desc *cmd;
+	int count;
+	int lo = 0;
+	int hi;
+
+	STRUCT_SECTION_COUNT(cmd_desc, &count);
+	hi = count - 1;
+
+	while (lo <= hi) {
+		int mid = lo + (hi - lo) / 2;
+		int cmp;
+
+		STRUCT_SECTION_GET(cmd_desc, mid, &cmd);
+		cmp = strcmp(name, cmd->name);
+		if (cmp == 0) {
+			return cmd;
+		} else if (cmp < 0) {
+			hi = mid - 1;
+		} else {
+			lo = mid + 1;
+		}
+	}
+
+	return NULL;
+}
+
+#ifdef CONFIG_CMD_LOOKUP_PHASH
+/* Perfect hash over the descriptors: one hash, one comparison. */
+static const struct cmd_desc *cmd_phash_find(const char *name)
+{
+	const struct cmd_desc *cmd;
+	size_t len;
+	uint32_t slot = cmd_phash_slot(&cmd_hash_table, cmd_phash_str(name, &len));
+
+	if (len != cmd_hash_table.len[slot]) {
+		return NULL;
+	}
+
+	STRUCT_SECTION_GET(cmd_desc, cmd_hash_table.index[slot], &cmd);
+
+	return memcmp(name, cmd->name, len) == 0 ? cmd : NULL;
+}
+
+/*
+ * The table is generated from the sources by matching CMD_DEFINE() lines, so
+ * it can miss commands defined through other macros, or list commands that
+ * are compiled out. Check once that it maps every descriptor to itself and
+ * fall back to the binary search otherwise.
+ */
+static bool cmd_phash_valid(void)
+{
+	static int valid = -1;
+	int count;
+
+	if (valid >= 0) {
+		return valid;
+	}
+
+	STRUCT_SECTION_COUNT(cmd_desc, &count);
+	valid = (count == CMD_HASH_COUNT);
+
+	STRUCT_SECTION_FOREACH(cmd_desc, cmd) {
+		if (!valid || cmd_phash_find(cmd->name) != cmd) {
+			valid = false;
+			break;
+		}
+	}
+
+	if (!valid) {
+		printk("Command hash table out of date, using binary search\n");
+	}
+
+	return valid;
+}
+#endif /* CONFIG_CMD_LOOKUP_PHASH */
+
+int cmd_table_check(void)
+{
+	const char *prev = NULL;
+
+	STRUCT_SECTION_FOREACH(cmd_desc, cmd) {
+		if (prev != NULL && strcmp(prev, cmd->name) >= 0) {
+			printk("Error: commands '%s' and '%s' are out of order, see CMD_DEFINE()\n",
+			       prev, cmd->name);
+			return -EINVAL;
+		}
+		prev = cmd->name;
+	}
+
+	return 0;
+}
+
+const struct cmd_desc *cmd_find(const char *name)
+{
+#ifdef CONFIG_CMD_LOOKUP_PHASH
+	if (cmd_phash_valid()) {
+		return cmd_phash_find(name);
+	}
+#endif
+	return cmd_bsearch(name);
+}
+
+int cmd_resolve(struct cmd_args *args, uint16_t tag, struct cmd_rsp *rsp,
+		const struct cmd_desc **cmd)
+{
+	struct cmd_ctx ctx = {
+		.args = args,
+		.rsp = rsp,
+	};
+	int nargs = args->argc - 1;
+
+	if (tag != CMD_STREAM_NONE && tag != CMD_STREAM_UNKNOWN) {
+		/* resolved and checked while the line was received */
+		STRUCT_SECTION_GET(cmd_desc, tag - 1, cmd);
+		return 0;
+	}
+
+	ctx.cmd = (tag == CMD_STREAM_NONE) ? cmd_find(args->argv[0]) : NULL;
+	if (ctx.cmd == NULL) {
+		cmd_print(&ctx, "Error: Unknown command '%s'\r\n", args->argv[0]);
+		return -ENOENT;
+	}
+
+	if (nargs < ctx.cmd->min_args) {
+		cmd_print(&ctx, "Error: missing argument\r\nUsage: %s\r\n",
+			  ctx.cmd->help);
+		return -EINVAL;
+	}
+
+	if (nargs > ctx.cmd->max_args) {
+		/* point at the first argument too many */
+		cmd_print(&ctx, "Error: unexpected argument at column %u\r\nUsage: %s\r\n",
+			  args->span[ctx.cmd->max_args + 1].start + 1,
+			  ctx.cmd->help);
+		return -E2BIG;
+	}
+
+	*cmd = ctx.cmd;
+
+	return 0;
+}
+
+int cmd_run(const struct cmd_desc *cmd, struct cmd_args *args,
+	    struct cmd_rsp *rsp)
+{
+	struct cmd_ctx ctx = {
+		.cmd = cmd,
+		.args = args,
+		.rsp = rsp,
+	};
+
+	return cmd->handler(&ctx, args->argc, args->argv);
+}
+
+int cmd_dispatch(struct cmd_args *args, struct cmd_rsp *rsp)
+{
+	const struct cmd_desc *cmd;
+	int err;
+
+	err = cmd_resolve(args, CMD_STREAM_NONE, rsp, &cmd);
+	if (err < 0) {
+		return err;
+	}
+
+	return cmd_run(cmd, args, rsp);
+}
+
+/* room kept at the end of a reply for the line end of a truncated reply */
+#define CMD_RSP_RESERVE 2
+
+void cmd_rsp_init(struct cmd_rsp *rsp, uint32_t seq)
+{
+	rsp->seq = seq;
+	rsp->len = 0;
+	rsp->line_start = true;
+}
+
+static void cmd_rsp_append(struct cmd_rsp *rsp, const char *text)
+{
+	const size_t limit = sizeof(rsp->buf) - CMD_RSP_RESERVE;
+
+	for (; *text != '\0'; text++) {
+		if (rsp->line_start) {
+			char id[12];
+			int n = snprintk(id, sizeof(id), "#%u ", rsp->seq);
+
+			if (rsp->len + n >= limit) {
+				return;
+			}
+			memcpy(&rsp->buf[rsp->len], id, n);
+			rsp->len += n;
+			rsp->line_start = false;
+		}
+
+		if (rsp->len == limit) {
+			return;
+		}
+		rsp->buf[rsp->len++] = *text;
+		rsp->line_start = (*text == '\n');
+	}
+}
+
+size_t cmd_rsp_finish(struct cmd_rsp *rsp)
+{
+	if (!rsp->line_start && rsp->len > 0) {
+		rsp->buf[rsp->len++] = '\r';
+		rsp->buf[rsp->len++] = '\n';
+		rsp->line_start = true;
+	}
+
+	return rsp->len;
+}
+
+void cmd_print(const struct cmd_ctx *ctx, const char *fmt, ...)
+{
+	char buf[CMD_PRINT_MAX];
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintk(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+
+	if (ctx->rsp != NULL) {
+		cmd_rsp_append(ctx->rsp, buf);
+	} else {
+		print_uart(buf);
+	}
+}
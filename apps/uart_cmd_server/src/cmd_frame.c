@@ -0,0 +1,272 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
+
+#include <string.h>
+
+#include "cmd_dispatcher.h"
+#include "cmd_frame.h"
+#include "uart_handler.h"
+
+/* COBS groups hold at most 254 data bytes, flagged by code 0xFF */
+#define COBS_CODE_MAX 0xFF
+
+/* an encoded reply must fit the TX ring to be queued in one piece */
+#define CMD_FRAME_REPLY_MAX \
+	(CMD_FRAME_HDR_SIZE + 1 + CMD_FRAME_PAYLOAD_MAX + CMD_FRAME_CRC_SIZE)
+
+BUILD_ASSERT(CMD_FRAME_COBS_SIZE(CMD_FRAME_REPLY_MAX) <= CONFIG_CMD_SERVER_TX_RING_SIZE,
+	     "CONFIG_CMD_SERVER_TX_RING_SIZE too small for binary replies");
+
+/* frames decoded intact and frames thrown away */
+static atomic_t frames_ok;
+static atomic_t frames_bad;
+
+void cmd_frame_dec_reset(struct cmd_frame_dec *dec)
+{
+	dec->code = 0;
+	dec->left = 0;
+	dec->len = 0;
+	dec->payload_len = 0;
+	dec->crc = 0;
+}
+
+static enum cmd_frame_rx dec_emit(struct cmd_frame_dec *dec, uint8_t b,
+				  uint8_t *out)
+{
+	dec->crc = crc16_ccitt(dec->crc, &b, 1);
+
+	/* pick the payload length out of the header as it passes */
+	if (dec->len == 2) {
+		dec->payload_len = b;
+	} else if (dec->len == 3) {
+		dec->payload_len |= (uint16_t)b << 8;
+	}
+
+	if (dec->len < UINT16_MAX) {
+		dec->len++;
+	}
+	*out = b;
+
+	return CMD_FRAME_RX_BYTE;
+}
+
+enum cmd_frame_rx cmd_frame_dec_byte(struct cmd_frame_dec *dec, uint8_t in,
+				     uint8_t *out)
+{
+	bool intact;
+
+	if (in == 0) {
+		if (dec->code == 0) {
+			/* back-to-back delimiters, nothing was received */
+			return CMD_FRAME_RX_NONE;
+		}
+
+		/* a residue of 0 means the appended CRC matches */
+		intact = dec->left == 0 && dec->crc == 0 &&
+			 dec->len >= CMD_FRAME_HDR_SIZE + CMD_FRAME_CRC_SIZE &&
+			 dec->len == CMD_FRAME_HDR_SIZE + dec->payload_len +
+				     CMD_FRAME_CRC_SIZE;
+		cmd_frame_dec_reset(dec);
+
+		if (!intact) {
+			atomic_inc(&frames_bad);
+			return CMD_FRAME_RX_BAD;
+		}
+
+		atomic_inc(&frames_ok);
+		return CMD_FRAME_RX_END;
+	}
+
+	if (dec->left == 0) {
+		/* code byte: the previous group ended in a zero unless it was full */
+		bool zero = dec->code != 0 && dec->code != COBS_CODE_MAX;
+
+		dec->code = in;
+		dec->left = in - 1;
+
+		return zero ? dec_emit(dec, 0, out) : CMD_FRAME_RX_NONE;
+	}
+
+	dec->left--;
+
+	return dec_emit(dec, in, out);
+}
+
+/*
+ * COBS encoder writing into a buffer: every byte goes out as it is produced
+ * and only the code byte in front of the current group is filled in later.
+ */
+struct cobs_enc {
+	uint8_t *buf;
+	size_t pos;
+	size_t code_pos;
+	uint8_t code;
+};
+
+static void cobs_enc_init(struct cobs_enc *enc, uint8_t *buf)
+{
+	enc->buf = buf;
+	enc->code_pos = 0;
+	enc->pos = 1;
+	enc->code = 1;
+}
+
+static void cobs_enc_byte(struct cobs_enc *enc, uint8_t b)
+{
+	if (b != 0) {
+		enc->buf[enc->pos++] = b;
+		enc->code++;
+	}
+
+	if (b == 0 || enc->code == COBS_CODE_MAX) {
+		enc->buf[enc->code_pos] = enc->code;
+		enc->code_pos = enc->pos++;
+		enc->code = 1;
+	}
+}
+
+/* Close the last group and add the delimiter. Returns the encoded size. */
+static size_t cobs_enc_end(struct cobs_enc *enc)
+{
+	enc->buf[enc->code_pos] = enc->code;
+	enc->buf[enc->pos++] = 0;
+
+	return enc->pos;
+}
+
+static uint16_t enc_bytes(struct cobs_enc *enc, uint16_t crc,
+			  const uint8_t *data, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		crc = crc16_ccitt(crc, &data[i], 1);
+		cobs_enc_byte(enc, data[i]);
+	}
+
+	return crc;
+}
+
+int cmd_frame_rsp_put(struct cmd_frame_rsp *rsp, const void *data, size_t len)
+{
+	if (len > sizeof(rsp->buf) - rsp->len) {
+		return -ENOMEM;
+	}
+
+	memcpy(&rsp->buf[rsp->len], data, len);
+	rsp->len += len;
+
+	return 0;
+}
+
+int cmd_frame_rsp_put_le32(struct cmd_frame_rsp *rsp, uint32_t val)
+{
+	uint8_t le[4];
+
+	sys_put_le32(val, le);
+
+	return cmd_frame_rsp_put(rsp, le, sizeof(le));
+}
+
+static const struct cmd_frame_desc *cmd_frame_find(uint8_t id)
+{
+	STRUCT_SECTION_FOREACH(cmd_frame_desc, desc) {
+		if (desc->id == id) {
+			return desc;
+		}
+	}
+
+	return NULL;
+}
+
+void cmd_frame_handle(const uint8_t *frame, size_t len)
+{
+	static struct cmd_frame_rsp rsp;
+	static uint8_t out[CMD_FRAME_COBS_SIZE(CMD_FRAME_REPLY_MAX)];
+	const struct cmd_frame_desc *desc = cmd_frame_find(frame[0]);
+	struct cobs_enc enc;
+	uint8_t hdr[CMD_FRAME_HDR_SIZE];
+	uint8_t trailer[CMD_FRAME_CRC_SIZE];
+	int8_t status;
+	uint16_t crc;
+	struct uart_iov iov;
+
+	/* the decoder only hands over frames with a consistent length */
+	rsp.len = 0;
+	status = (desc != NULL) ?
+		 desc->handler(&frame[CMD_FRAME_HDR_SIZE],
+			       len - CMD_FRAME_HDR_SIZE - CMD_FRAME_CRC_SIZE, &rsp) :
+		 -ENOTSUP;
+
+	/* the status byte goes in front of the handler's data */
+	hdr[0] = frame[0] | CMD_FRAME_REPLY;
+	hdr[1] = frame[1];
+	sys_put_le16(1 + rsp.len, &hdr[2]);
+
+	cobs_enc_init(&enc, out);
+	crc = enc_bytes(&enc, 0, hdr, sizeof(hdr));
+	crc = enc_bytes(&enc, crc, (const uint8_t *)&status, 1);
+	crc = enc_bytes(&enc, crc, rsp.buf, rsp.len);
+	sys_put_le16(crc, trailer);
+	enc_bytes(&enc, crc, trailer, sizeof(trailer));
+
+	iov.base = out;
+	iov.len = cobs_enc_end(&enc);
+	print_uartv(&iov, 1, NULL);
+}
+
+static int frame_ping(const uint8_t *req, size_t len, struct cmd_frame_rsp *rsp)
+{
+	/* echo the payload, e.g. to measure the round trip */
+	return cmd_frame_rsp_put(rsp, req, len);
+}
+
+CMD_FRAME_DEFINE(ping, CMD_FRAME_PING, frame_ping);
+
+static int frame_telemetry(const uint8_t *req, size_t len,
+			   struct cmd_frame_rsp *rsp)
+{
+	ARG_UNUSED(req);
+	ARG_UNUSED(len);
+
+	/* fixed little-endian record, nothing to format or parse */
+	cmd_frame_rsp_put_le32(rsp, k_uptime_get_32());
+	cmd_frame_rsp_put_le32(rsp, k_cycle_get_32());
+	cmd_frame_rsp_put_le32(rsp, (uint32_t)atomic_get(&frames_ok));
+
+	return cmd_frame_rsp_put_le32(rsp, (uint32_t)atomic_get(&frames_bad));
+}
+
+CMD_FRAME_DEFINE(telemetry, CMD_FRAME_TELEMETRY, frame_telemetry);
+
+static int frame_text_mode(const uint8_t *req, size_t len,
+			   struct cmd_frame_rsp *rsp)
+{
+	ARG_UNUSED(req);
+	ARG_UNUSED(len);
+	ARG_UNUSED(rsp);
+
+	/*
+	 * The framer switches before the next byte it receives; the client
+	 * waits for this reply before it sends text.
+	 */
+	uart_handler_set_binary(false);
+
+	return 0;
+}
+
+CMD_FRAME_DEFINE(text_mode, CMD_FRAME_TEXT_MODE, frame_text_mode);
+
+static int cmd_binary(const struct cmd_ctx *ctx, int argc, char **argv)
+{
+	cmd_print(ctx, "OK binary\r\n");
+	uart_handler_set_binary(true);
+
+	return 0;
+}
+
+CMD_DEFINE(binary, cmd_binary, "binary  Switch to binary frames (COBS + CRC16)", 0, 0,
+	   CMD_CLASS_BULK);
@@ -0,0 +1,170 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmd_dispatcher.h"
+
+/* simulated LED switched by the led command */
+static bool led_on;
+
+static int cmd_help(const struct cmd_ctx *ctx, int argc, char **argv)
+{
+	const char *sep = "";
+
+	if (argc == 2) {
+		const struct cmd_desc *cmd = cmd_find(argv[1]);
+
+		if (cmd == NULL) {
+			cmd_print(ctx, "Error: Unknown command '%s'\r\n", argv[1]);
+			return -ENOENT;
+		}
+		cmd_print(ctx, "%s\r\n", cmd->help);
+		return 0;
+	}
+
+	cmd_print(ctx, "Available commands: ");
+	STRUCT_SECTION_FOREACH(cmd_desc, cmd) {
+		cmd_print(ctx, "%s%s", sep, cmd->name);
+		sep = ", ";
+	}
+	cmd_print(ctx, "\r\n");
+
+	return 0;
+}
+
+CMD_DEFINE(help, cmd_help, "help [command]  List commands or show usage", 0, 1,
+	   CMD_CLASS_BULK);
+
+static void count_thread(const struct k_thread *thread, void *user_data)
+{
+	int *threads = user_data;
+
+	ARG_UNUSED(thread);
+	(*threads)++;
+}
+
+static int cmd_status(const struct cmd_ctx *ctx, int argc, char **argv)
+{
+	int threads = 0;
+
+	k_thread_foreach(count_thread, &threads);
+
+	cmd_print(ctx, "Uptime: %u ms | Active threads: %d\r\n",
+		  (uint32_t)k_uptime_get(), threads);
+
+	return 0;
+}
+
+CMD_DEFINE(status, cmd_status, "status  Print system uptime and thread count", 0, 0,
+	   CMD_CLASS_BULK);
+
+static int cmd_led(const struct cmd_ctx *ctx, int argc, char **argv)
+{
+	if (strcmp(argv[1], "on") == 0) {
+		led_on = true;
+	} else if (strcmp(argv[1], "off") == 0) {
+		led_on = false;
+	} else {
+		cmd_print(ctx, "Error: expected 'on' or 'off' at column %u\r\n",
+			  ctx->args->span[1].start + 1);
+		return -EINVAL;
+	}
+
+	cmd_print(ctx, "LED is now %s\r\n", led_on ? "ON" : "OFF");
+
+	return 0;
+}
+
+CMD_DEFINE(led, cmd_led, "led on|off  Switch the simulated LED", 1, 1,
+	   CMD_CLASS_URGENT);
+
+static int cmd_count(const struct cmd_ctx *ctx, int argc, char **argv)
+{
+	/* handlers run on several work queue threads */
+	static atomic_t counter;
+
+	cmd_print(ctx, "Count: %u\r\n", (uint32_t)atomic_inc(&counter) + 1);
+
+	return 0;
+}
+
+CMD_DEFINE(count, cmd_count, "count  Print a running counter value", 0, 0,
+	   CMD_CLASS_URGENT);
+
+/* wakes delay commands early, bumped by the stop command */
+static K_MUTEX_DEFINE(stop_lock);
+static K_CONDVAR_DEFINE(stop_cond);
+static uint32_t stop_gen;
+
+static int cmd_delay(const struct cmd_ctx *ctx, int argc, char **argv)
+{
+	char *end;
+	unsigned long ms = strtoul(argv[1], &end, 10);
+	int64_t start = k_uptime_get();
+	int64_t left = ms;
+	uint32_t gen;
+
+	if (*end != '\0' || ms > 60000) {
+		cmd_print(ctx, "Error: expected 0 to 60000 ms at column %u\r\n",
+			  ctx->args->span[1].start + 1);
+		return -EINVAL;
+	}
+
+	/* stands in for a slow command, other requests keep flowing */
+	k_mutex_lock(&stop_lock, K_FOREVER);
+	gen = stop_gen;
+	while (gen == stop_gen && left > 0) {
+		k_condvar_wait(&stop_cond, &stop_lock, K_MSEC(left));
+		left = start + ms - k_uptime_get();
+	}
+	k_mutex_unlock(&stop_lock);
+
+	if (left > 0) {
+		cmd_print(ctx, "Stopped after %u ms\r\n",
+			  (uint32_t)(k_uptime_get() - start));
+		return -ECANCELED;
+	}
+
+	cmd_print(ctx, "Delayed %lu ms\r\n", ms);
+
+	return 0;
+}
+
+CMD_DEFINE(delay, cmd_delay, "delay <ms>  Reply after the given time", 1, 1,
+	   CMD_CLASS_BULK);
+
+static int cmd_stop(const struct cmd_ctx *ctx, int argc, char **argv)
+{
+	int woken;
+
+	k_mutex_lock(&stop_lock, K_FOREVER);
+	stop_gen++;
+	woken = k_condvar_broadcast(&stop_cond);
+	k_mutex_unlock(&stop_lock);
+
+	cmd_print(ctx, "Stopped %d command(s)\r\n", woken);
+
+	return 0;
+}
+
+/* urgent, so it overtakes the bulk commands it is meant to cut short */
+CMD_DEFINE(stop, cmd_stop, "stop  End running delay commands early", 0, 0,
+	   CMD_CLASS_URGENT);
+
+static int cmd_echo(const struct cmd_ctx *ctx, int argc, char **argv)
+{
+	for (int i = 1; i < argc; i++) {
+		cmd_print(ctx, "%s%s", argv[i], (i + 1 < argc) ? " " : "");
+	}
+	cmd_print(ctx, "\r\n");
+
+	return 0;
+}
+
+CMD_DEFINE(echo, cmd_echo, "echo <text>  Echo back the text", 0, CMD_ARGC_MAX - 1,
+	   CMD_CLASS_BULK);
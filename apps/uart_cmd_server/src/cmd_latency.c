@@ -0,0 +1,135 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+
+#include "cmd_dispatcher.h"
+#include "cmd_latency.h"
+#include "uart_handler.h"
+
+/* replies whose TX completion can be waited for at a time */
+#define LAT_PENDING_COUNT 8
+
+struct lat_pending {
+	/* NULL if the entry is free */
+	struct cmd_lat *lat;
+	uint32_t mark;
+	struct cmd_lat_stamps stamps;
+};
+
+static struct lat_pending pending[LAT_PENDING_COUNT];
+static struct k_spinlock pending_lock;
+
+/* samples lost because too many replies were in flight */
+static uint32_t pending_lost;
+
+static const char *const span_names[CMD_LAT_SPANS] = {
+	"rx", "ring", "sched", "handler", "tx", "total",
+};
+
+BUILD_ASSERT(CMD_LAT_SPANS == 6, "CMD_LAT_DEFINE() initializes six spans");
+
+/* Lock-free, so it can run in the TX drain. */
+static void lat_record(struct cmd_lat *lat, const struct cmd_lat_stamps *stamps)
+{
+	for (int i = 0; i < CMD_LAT_SPAN_TOTAL; i++) {
+		lat_hist_record(&lat->span[i], stamps->t[i + 1] - stamps->t[i]);
+	}
+	lat_hist_record(&lat->span[CMD_LAT_SPAN_TOTAL],
+			stamps->t[CMD_LAT_TX] - stamps->t[CMD_LAT_ISR]);
+}
+
+void cmd_lat_tx_sent(uint32_t sent)
+{
+	k_spinlock_key_t key = k_spin_lock(&pending_lock);
+
+	for (int i = 0; i < LAT_PENDING_COUNT; i++) {
+		struct lat_pending *p = &pending[i];
+
+		if (p->lat == NULL || (int32_t)(sent - p->mark) < 0) {
+			continue;
+		}
+
+		CMD_LAT_STAMP(&p->stamps, CMD_LAT_TX);
+		lat_record(p->lat, &p->stamps);
+		p->lat = NULL;
+	}
+
+	k_spin_unlock(&pending_lock, key);
+}
+
+void cmd_lat_tx_queued(struct cmd_lat *lat, const struct cmd_lat_stamps *stamps,
+		       uint32_t mark)
+{
+	k_spinlock_key_t key = k_spin_lock(&pending_lock);
+	int i;
+
+	for (i = 0; i < LAT_PENDING_COUNT; i++) {
+		if (pending[i].lat == NULL) {
+			pending[i].lat = lat;
+			pending[i].mark = mark;
+			pending[i].stamps = *stamps;
+			break;
+		}
+	}
+
+	if (i == LAT_PENDING_COUNT) {
+		pending_lost++;
+	}
+
+	k_spin_unlock(&pending_lock, key);
+
+	/* the drain may have passed the mark before the entry was added */
+	cmd_lat_tx_sent(uart_tx_sent());
+}
+
+/* Summary of one span in microseconds */
+static void span_summary(struct cmd_lat *lat, int span, struct lat_hist_summary *sum)
+{
+	lat_hist_summary(&lat->span[span], sum);
+
+	sum->min = k_cyc_to_us_floor32(sum->min);
+	sum->mean = k_cyc_to_us_floor32(sum->mean);
+	sum->p50 = k_cyc_to_us_floor32(sum->p50);
+	sum->p90 = k_cyc_to_us_floor32(sum->p90);
+	sum->p99 = k_cyc_to_us_floor32(sum->p99);
+	sum->max = k_cyc_to_us_floor32(sum->max);
+}
+
+static int cmd_stats(const struct cmd_ctx *ctx, int argc, char **argv)
+{
+	const struct cmd_desc *cmd;
+	struct lat_hist_summary sum;
+
+	if (argc == 1) {
+		/* end-to-end latency of every command used so far */
+		STRUCT_SECTION_FOREACH(cmd_desc, desc) {
+			span_summary(desc->lat, CMD_LAT_SPAN_TOTAL, &sum);
+			if (sum.count == 0) {
+				continue;
+			}
+			cmd_print(ctx, "%-8s n %u avg %u p99 %u max %u us\r\n",
+				  desc->name, sum.count, sum.mean, sum.p99, sum.max);
+		}
+		cmd_print(ctx, "lost %u\r\n", pending_lost);
+		return 0;
+	}
+
+	cmd = cmd_find(argv[1]);
+	if (cmd == NULL) {
+		cmd_print(ctx, "Error: Unknown command '%s'\r\n", argv[1]);
+		return -ENOENT;
+	}
+
+	for (int i = 0; i < CMD_LAT_SPANS; i++) {
+		span_summary(cmd->lat, i, &sum);
+		cmd_print(ctx, "%-8s min %u avg %u max %u p99 %u us\r\n",
+			  span_names[i], sum.min, sum.mean, sum.max, sum.p99);
+	}
+
+	return 0;
+}
+
+CMD_DEFINE(stats, cmd_stats, "stats [command]  Show command latency per stage",
+	   0, 1, CMD_CLASS_BULK);
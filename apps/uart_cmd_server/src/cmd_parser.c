@@ -0,0 +1,130 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "cmd_parser.h"
+
+#include <stdbool.h>
+
+static inline bool is_space(char c)
+{
+	return c == ' ' || c == '\t';
+}
+
+static inline char unescape(char c)
+{
+	switch (c) {
+	case 'n':
+		return '\n';
+	case 'r':
+		return '\r';
+	case 't':
+		return '\t';
+	default:
+		return c;
+	}
+}
+
+enum cmd_parse_error cmd_parse(char *line, size_t len, struct cmd_args *args,
+			       struct cmd_span *err_span)
+{
+	const char *end = line + len;
+	char *rd = line;
+	char *wr;
+	char *tok_start;
+	char quote;
+
+	args->argc = 0;
+
+	for (;;) {
+		while (rd < end && is_space(*rd)) {
+			rd++;
+		}
+		if (rd == end) {
+			break;
+		}
+
+		if (args->argc == CMD_ARGC_MAX) {
+			if (err_span != NULL) {
+				err_span->start = rd - line;
+				err_span->len = end - rd;
+			}
+			return CMD_PARSE_TOO_MANY_ARGS;
+		}
+
+		/* unescaped text is never longer, so it is written behind rd */
+		tok_start = rd;
+		wr = rd;
+		quote = '\0';
+
+		while (rd < end && (quote != '\0' || !is_space(*rd))) {
+			char c = *rd++;
+
+			if (quote == '\'') {
+				if (c == '\'') {
+					quote = '\0';
+				} else {
+					*wr++ = c;
+				}
+			} else if (c == '\\') {
+				if (rd == end) {
+					if (err_span != NULL) {
+						err_span->start = rd - 1 - line;
+						err_span->len = 1;
+					}
+					return CMD_PARSE_TRAILING_ESCAPE;
+				}
+				*wr++ = unescape(*rd++);
+			} else if (quote == '"') {
+				if (c == '"') {
+					quote = '\0';
+				} else {
+					*wr++ = c;
+				}
+			} else if (c == '"' || c == '\'') {
+				quote = c;
+			} else {
+				*wr++ = c;
+			}
+		}
+
+		if (quote != '\0') {
+			if (err_span != NULL) {
+				err_span->start = tok_start - line;
+				err_span->len = end - tok_start;
+			}
+			return CMD_PARSE_OPEN_QUOTE;
+		}
+
+		args->argv[args->argc] = tok_start;
+		args->span[args->argc].start = tok_start - line;
+		args->span[args->argc].len = rd - tok_start;
+		args->argc++;
+
+		/* wr <= rd, and rd is either a separator or the terminator */
+		*wr = '\0';
+		if (rd < end) {
+			rd++;
+		}
+	}
+
+	args->argv[args->argc] = NULL;
+
+	return CMD_PARSE_OK;
+}
+
+const char *cmd_parse_strerror(enum cmd_parse_error err)
+{
+	switch (err) {
+	case CMD_PARSE_OK:
+		return "no error";
+	case CMD_PARSE_TOO_MANY_ARGS:
+		return "too many arguments";
+	case CMD_PARSE_OPEN_QUOTE:
+		return "unterminated quote";
+	case CMD_PARSE_TRAILING_ESCAPE:
+		return "backslash at end of line";
+	default:
+		return "invalid command line";
+	}
+}
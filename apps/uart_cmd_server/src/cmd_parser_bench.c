@@ -0,0 +1,66 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+
+#include <string.h>
+
+#include "cmd_parser.h"
+
+#define BENCH_ROUNDS 1000
+
+static const char *const bench_lines[] = {
+	"help",
+	"led on",
+	"echo Hello Zephyr",
+	"echo \"quoted argument\" 'single quoted' plain",
+	"set a\\ b \"x\\ty\" 12345 67890 last",
+};
+
+/* cycles spent by a back-to-back pair of k_cycle_get_32() calls */
+static uint32_t bench_overhead(void)
+{
+	uint32_t best = UINT32_MAX;
+
+	for (int i = 0; i < 16; i++) {
+		uint32_t start = k_cycle_get_32();
+
+		best = MIN(best, k_cycle_get_32() - start);
+	}
+
+	return best;
+}
+
+void cmd_parser_bench(void)
+{
+	static char line[CONFIG_CMD_SERVER_LINE_MAX + 1];
+	struct cmd_args args;
+	uint32_t overhead = bench_overhead();
+
+	printk("cmd_parse() benchmark, %d rounds per line\n", BENCH_ROUNDS);
+
+	for (size_t n = 0; n < ARRAY_SIZE(bench_lines); n++) {
+		size_t len = strlen(bench_lines[n]);
+		uint64_t cycles = 0;
+
+		for (int i = 0; i < BENCH_ROUNDS; i++) {
+			uint32_t start;
+			uint32_t elapsed;
+
+			/* tokenizing is destructive, restore the line untimed */
+			memcpy(line, bench_lines[n], len + 1);
+
+			start = k_cycle_get_32();
+			cmd_parse(line, len, &args, NULL);
+			elapsed = k_cycle_get_32() - start;
+
+			cycles += elapsed > overhead ? elapsed - overhead : 0;
+		}
+
+		cycles /= BENCH_ROUNDS;
+		printk("%-48s %d tokens %5u cycles/line %4u cycles/token\n",
+		       bench_lines[n], args.argc, (uint32_t)cycles,
+		       (uint32_t)(cycles / MAX(args.argc, 1)));
+	}
+}
@@ -0,0 +1,370 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+
+#include "cmd_dispatcher.h"
+#include "cmd_latency.h"
+#include "cmd_pipeline.h"
+#include "line_ring.h"
+#include "uart_handler.h"
+
+#define BULK_QUEUES CONFIG_CMD_SERVER_WORKERS
+#define BULK_STACK_SIZE CONFIG_CMD_SERVER_WORKER_STACK_SIZE
+#define BULK_PRIORITY CONFIG_CMD_SERVER_WORKER_PRIORITY
+
+/* one request slot is always left for urgent commands */
+#define BULK_SLOTS (CONFIG_CMD_SERVER_PIPELINE_DEPTH - 1)
+#define BULK_BACKLOG CONFIG_CMD_SERVER_BULK_BACKLOG
+
+/* a reply is queued to the TX ring in one piece */
+BUILD_ASSERT(CONFIG_CMD_SERVER_RSP_SIZE <= CONFIG_CMD_SERVER_TX_RING_SIZE,
+	     "CONFIG_CMD_SERVER_TX_RING_SIZE too small for a full reply");
+
+struct cmd_req {
+	/* reserved for the kernel's FIFO */
+	void *fifo_reserved;
+	const struct cmd_desc *cmd;
+	/* cycle count when the request was accepted by req_queue() */
+	uint32_t queued;
+	/* in the bulk backlog while waiting for a slot */
+	sys_snode_t backlog_node;
+#ifdef CONFIG_CMD_LATENCY
+	struct cmd_lat_stamps lat;
+#endif
+	/* the line in the RX ring, argv points into it */
+	char *line;
+	struct cmd_args args;
+	struct cmd_rsp rsp;
+};
+
+/*
+ * A lane feeds requests to one work queue. Requests wait in the lane's FIFO
+ * and are run by a single work item that lives as long as the lane, so a
+ * request can be freed as soon as it is answered, while the work queue
+ * still owns the item.
+ */
+struct cmd_lane {
+	struct k_work_q *queue;
+	struct k_work work;
+	struct k_fifo fifo;
+	/* requests queued or running on this lane */
+	atomic_t pending;
+};
+
+/* counters of one command class, see the queues command */
+struct cmd_class_stats {
+	struct k_spinlock lock;
+	/* requests queued or running, and the most there have been */
+	uint32_t depth;
+	uint32_t peak;
+	/* completed requests and their cycles from queueing to the handler */
+	uint32_t done;
+	uint64_t wait_sum;
+	uint32_t wait_max;
+	/* requests turned away because the backlog was full */
+	uint32_t busy;
+};
+
+/* the backlog has blocks of its own, so it never uses the urgent slot */
+K_MEM_SLAB_DEFINE_STATIC(req_slab, sizeof(struct cmd_req),
+			 CONFIG_CMD_SERVER_PIPELINE_DEPTH + BULK_BACKLOG, 4);
+
+/*
+ * Bulk requests that found every bulk slot taken wait in the backlog until
+ * a bulk handler returns, so the RX thread never blocks on bulk work and
+ * still reads a stop sent behind it.
+ */
+static struct k_spinlock bulk_lock;
+static uint32_t bulk_free = BULK_SLOTS;
+static sys_slist_t bulk_backlog = SYS_SLIST_STATIC_INIT(&bulk_backlog);
+static uint32_t backlog_len;
+
+K_THREAD_STACK_ARRAY_DEFINE(bulk_stacks, BULK_QUEUES, BULK_STACK_SIZE);
+static struct k_work_q bulk_queues[BULK_QUEUES];
+
+/* the urgent lane on the system workqueue, then one lane per bulk queue */
+#define URGENT_LANE 0
+static struct cmd_lane lanes[1 + BULK_QUEUES];
+
+static struct cmd_class_stats class_stats[CMD_CLASS_COUNT];
+
+static const char *const class_names[CMD_CLASS_COUNT] = {
+	[CMD_CLASS_URGENT] = "urgent",
+	[CMD_CLASS_BULK] = "bulk",
+};
+
+/* ring the lines are parsed in, given back to it once answered */
+static struct line_ring *rx_ring;
+
+/* id of the next request, only used by the RX thread */
+static uint32_t next_seq;
+
+/* TX stage: queue the reply as one transmission, recycle request and line */
+static void req_complete(struct cmd_req *req)
+{
+	struct uart_iov iov = {
+		.base = req->rsp.buf,
+		.len = cmd_rsp_finish(&req->rsp),
+	};
+
+	uint32_t mark = 0;
+	int ret = -ENODATA;
+
+	if (iov.len > 0) {
+		ret = print_uartv(&iov, 1, &mark);
+	}
+
+#ifdef CONFIG_CMD_LATENCY
+	/* only requests that reached their handler and were sent have all stamps */
+	if (req->cmd != NULL && ret == 0) {
+		cmd_lat_tx_queued(req->cmd->lat, &req->lat, mark);
+	}
+#else
+	ARG_UNUSED(ret);
+	ARG_UNUSED(mark);
+#endif
+
+	line_ring_release(rx_ring, req->line);
+	k_mem_slab_free(&req_slab, req);
+}
+
+static void lane_queue(struct cmd_lane *lane, struct cmd_req *req)
+{
+	atomic_inc(&lane->pending);
+	k_fifo_put(&lane->fifo, req);
+	k_work_submit_to_queue(lane->queue, &lane->work);
+}
+
+/* the bulk lane with the fewest requests queued or running */
+static struct cmd_lane *bulk_lane(void)
+{
+	struct cmd_lane *best = &lanes[1];
+
+	for (int i = 2; i < ARRAY_SIZE(lanes); i++) {
+		if (atomic_get(&lanes[i].pending) < atomic_get(&best->pending)) {
+			best = &lanes[i];
+		}
+	}
+
+	return best;
+}
+
+/* A bulk handler returned: hand its slot to the oldest waiting request. */
+static void bulk_slot_free(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&bulk_lock);
+	sys_snode_t *node = sys_slist_get(&bulk_backlog);
+	struct cmd_req *next = NULL;
+
+	if (node != NULL) {
+		next = CONTAINER_OF(node, struct cmd_req, backlog_node);
+		backlog_len--;
+	} else {
+		bulk_free++;
+	}
+
+	k_spin_unlock(&bulk_lock, key);
+
+	if (next != NULL) {
+		lane_queue(bulk_lane(), next);
+	}
+}
+
+static void req_run(struct cmd_req *req)
+{
+	enum cmd_class cls = req->cmd->cls;
+	struct cmd_class_stats *stats = &class_stats[cls];
+	uint32_t wait = k_cycle_get_32() - req->queued;
+	k_spinlock_key_t key;
+
+	CMD_LAT_STAMP(&req->lat, CMD_LAT_DISPATCH);
+	cmd_run(req->cmd, &req->args, &req->rsp);
+	CMD_LAT_STAMP(&req->lat, CMD_LAT_HANDLER);
+	req_complete(req);
+
+	key = k_spin_lock(&stats->lock);
+	stats->depth--;
+	stats->done++;
+	stats->wait_sum += wait;
+	stats->wait_max = MAX(stats->wait_max, wait);
+	k_spin_unlock(&stats->lock, key);
+
+	if (cls == CMD_CLASS_BULK) {
+		bulk_slot_free();
+	}
+}
+
+static void lane_work(struct k_work *work)
+{
+	struct cmd_lane *lane = CONTAINER_OF(work, struct cmd_lane, work);
+	struct cmd_req *req;
+
+	/* a submit while this runs queues the item again, nothing is missed */
+	while ((req = k_fifo_get(&lane->fifo, K_NO_WAIT)) != NULL) {
+		req_run(req);
+		atomic_dec(&lane->pending);
+	}
+}
+
+/*
+ * Take a bulk slot, or else a place in the backlog. Returns 1 with a slot,
+ * 0 if the request was parked and -EBUSY if the backlog is full.
+ */
+static int bulk_admit(struct cmd_req *req)
+{
+	k_spinlock_key_t key = k_spin_lock(&bulk_lock);
+	int ret = -EBUSY;
+
+	if (bulk_free > 0) {
+		bulk_free--;
+		ret = 1;
+	} else if (backlog_len < BULK_BACKLOG) {
+		/* under the lock, so a slot freed meanwhile still finds it */
+		backlog_len++;
+		sys_slist_append(&bulk_backlog, &req->backlog_node);
+		ret = 0;
+	}
+
+	k_spin_unlock(&bulk_lock, key);
+
+	return ret;
+}
+
+static void req_queue(struct cmd_req *req)
+{
+	struct cmd_class_stats *stats = &class_stats[req->cmd->cls];
+	k_spinlock_key_t key;
+	int ret;
+
+	/* counted first, a parked request may run before bulk_admit() returns */
+	key = k_spin_lock(&stats->lock);
+	stats->depth++;
+	stats->peak = MAX(stats->peak, stats->depth);
+	k_spin_unlock(&stats->lock, key);
+
+	req->queued = k_cycle_get_32();
+
+	if (req->cmd->cls == CMD_CLASS_URGENT) {
+		lane_queue(&lanes[URGENT_LANE], req);
+		return;
+	}
+
+	ret = bulk_admit(req);
+	if (ret > 0) {
+		lane_queue(bulk_lane(), req);
+	} else if (ret < 0) {
+		struct cmd_ctx ctx = {
+			.rsp = &req->rsp,
+		};
+
+		key = k_spin_lock(&stats->lock);
+		stats->depth--;
+		stats->busy++;
+		k_spin_unlock(&stats->lock, key);
+
+		cmd_print(&ctx, "Error: Busy, %d commands waiting\r\n", BULK_BACKLOG);
+		/* never ran, so there is no latency sample */
+		req->cmd = NULL;
+		req_complete(req);
+	}
+}
+
+void cmd_pipeline_submit(char *line, size_t len, uint16_t tag)
+{
+	struct cmd_req *req;
+	struct cmd_span err_span;
+	enum cmd_parse_error err;
+#ifdef CONFIG_CMD_LATENCY
+	uint32_t dequeued = k_cycle_get_32();
+#endif
+
+	/* bounds the requests in flight, the RX ring buffers meanwhile */
+	k_mem_slab_alloc(&req_slab, (void **)&req, K_FOREVER);
+
+#ifdef CONFIG_CMD_LATENCY
+	line_ring_stamps(line, &req->lat.t[CMD_LAT_ISR], &req->lat.t[CMD_LAT_LINE]);
+	req->lat.t[CMD_LAT_DEQUEUE] = dequeued;
+#endif
+
+	req->cmd = NULL;
+	req->line = line;
+	cmd_rsp_init(&req->rsp, next_seq++);
+
+	err = cmd_parse(req->line, len, &req->args, &err_span);
+	if (err != CMD_PARSE_OK) {
+		struct cmd_ctx ctx = {
+			.rsp = &req->rsp,
+		};
+
+		/* reported in order, there is nothing to run */
+		cmd_print(&ctx, "Error: %s at column %u\r\n",
+			  cmd_parse_strerror(err), err_span.start + 1);
+		req_complete(req);
+		return;
+	}
+
+	if (req->args.argc == 0) {
+		line_ring_release(rx_ring, line);
+		k_mem_slab_free(&req_slab, req);
+		return;
+	}
+
+	/* unknown commands and wrong argument counts are answered right away */
+	if (cmd_resolve(&req->args, tag, &req->rsp, &req->cmd) < 0) {
+		req_complete(req);
+		return;
+	}
+
+	req_queue(req);
+}
+
+static void lane_init(struct cmd_lane *lane, struct k_work_q *queue)
+{
+	lane->queue = queue;
+	k_work_init(&lane->work, lane_work);
+	k_fifo_init(&lane->fifo);
+}
+
+void cmd_pipeline_init(struct line_ring *ring)
+{
+	const struct k_work_queue_config cfg = {
+		.name = "cmd_bulk",
+	};
+
+	rx_ring = ring;
+
+	lane_init(&lanes[URGENT_LANE], &k_sys_work_q);
+
+	for (int i = 0; i < BULK_QUEUES; i++) {
+		k_work_queue_init(&bulk_queues[i]);
+		k_work_queue_start(&bulk_queues[i], bulk_stacks[i],
+				   K_THREAD_STACK_SIZEOF(bulk_stacks[i]),
+				   BULK_PRIORITY, &cfg);
+		lane_init(&lanes[1 + i], &bulk_queues[i]);
+	}
+}
+
+static int cmd_queues(const struct cmd_ctx *ctx, int argc, char **argv)
+{
+	for (int i = 0; i < CMD_CLASS_COUNT; i++) {
+		struct cmd_class_stats *stats = &class_stats[i];
+		struct cmd_class_stats snap;
+		k_spinlock_key_t key;
+
+		key = k_spin_lock(&stats->lock);
+		snap = *stats;
+		k_spin_unlock(&stats->lock, key);
+
+		cmd_print(ctx, "%-6s depth %u peak %u done %u busy %u wait avg %u max %u us\r\n",
+			  class_names[i], snap.depth, snap.peak, snap.done, snap.busy,
+			  snap.done > 0 ? k_cyc_to_us_floor32(snap.wait_sum / snap.done) : 0,
+			  k_cyc_to_us_floor32(snap.wait_max));
+	}
+
+	return 0;
+}
+
+CMD_DEFINE(queues, cmd_queues, "queues  Show depth and wait time per command class",
+	   0, 0, CMD_CLASS_URGENT);
@@ -0,0 +1,180 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/toolchain.h>
+
+#include "cmd_dispatcher.h"
+#include "cmd_stream.h"
+
+enum stream_state {
+	/* blanks before the command name */
+	STREAM_START,
+	/* inside the command name */
+	STREAM_NAME,
+	/* blanks between arguments */
+	STREAM_BLANK,
+	/* inside an argument */
+	STREAM_ARG,
+	/* the name is quoted or escaped, leave the line to cmd_find() */
+	STREAM_GIVE_UP,
+};
+
+static inline bool is_space(char c)
+{
+	return c == ' ' || c == '\t';
+}
+
+/*
+ * First command in [lo, hi) whose name has a byte of at least c at depth.
+ * Names in the range share their first depth bytes, so they are sorted by
+ * this byte, and a name that ends at depth sorts first with its NUL. The
+ * table order is checked once by cmd_table_check() before RX starts.
+ */
+static uint16_t name_bound(const struct cmd_stream *s, uint16_t lo, uint8_t c)
+{
+	uint16_t hi = s->hi;
+
+	while (lo < hi) {
+		uint16_t mid = lo + (hi - lo) / 2;
+		const struct cmd_desc *cmd;
+
+		STRUCT_SECTION_GET(cmd_desc, mid, &cmd);
+		if ((uint8_t)cmd->name[s->depth] < c) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+static void name_byte(struct cmd_stream *s, uint8_t c)
+{
+	if (s->lo < s->hi) {
+		s->lo = name_bound(s, s->lo, c);
+		/* the upper bound can only lie at or above the lower one */
+		if (c != UINT8_MAX) {
+			s->hi = name_bound(s, s->lo, c + 1);
+		}
+	}
+	s->depth++;
+}
+
+static void name_end(struct cmd_stream *s)
+{
+	const struct cmd_desc *cmd;
+
+	s->cmd = -1;
+	if (s->lo < s->hi) {
+		STRUCT_SECTION_GET(cmd_desc, s->lo, &cmd);
+		if (cmd->name[s->depth] == '\0') {
+			s->cmd = s->lo;
+		}
+	}
+}
+
+void cmd_stream_reset(struct cmd_stream *s)
+{
+	s->state = STREAM_START;
+	s->quote = '\0';
+	s->escape = false;
+	s->argc = 0;
+}
+
+void cmd_stream_feed(struct cmd_stream *s, char c)
+{
+	int count;
+
+	switch (s->state) {
+	case STREAM_START:
+		if (is_space(c)) {
+			return;
+		}
+		if (c == '"' || c == '\'' || c == '\\' || c == '\0') {
+			s->state = STREAM_GIVE_UP;
+			return;
+		}
+		STRUCT_SECTION_COUNT(cmd_desc, &count);
+		s->lo = 0;
+		s->hi = count;
+		s->depth = 0;
+		s->argc = 1;
+		s->state = STREAM_NAME;
+		__fallthrough;
+
+	case STREAM_NAME:
+		if (is_space(c)) {
+			name_end(s);
+			s->state = STREAM_BLANK;
+		} else if (c == '"' || c == '\'' || c == '\\' || c == '\0') {
+			s->state = STREAM_GIVE_UP;
+		} else {
+			name_byte(s, c);
+		}
+		return;
+
+	case STREAM_BLANK:
+		if (is_space(c)) {
+			return;
+		}
+		/* saturate, anything beyond the limit is rejected anyway */
+		if (s->argc <= CMD_ARGC_MAX) {
+			s->argc++;
+		}
+		s->state = STREAM_ARG;
+		__fallthrough;
+
+	case STREAM_ARG:
+		/* same rules as cmd_parse(), without resolving anything */
+		if (s->escape) {
+			s->escape = false;
+		} else if (s->quote == '\'') {
+			if (c == '\'') {
+				s->quote = '\0';
+			}
+		} else if (c == '\\') {
+			s->escape = true;
+		} else if (s->quote == '"') {
+			if (c == '"') {
+				s->quote = '\0';
+			}
+		} else if (c == '"' || c == '\'') {
+			s->quote = c;
+		} else if (is_space(c)) {
+			s->state = STREAM_BLANK;
+		}
+		return;
+
+	default:
+		return;
+	}
+}
+
+uint16_t cmd_stream_end(struct cmd_stream *s)
+{
+	const struct cmd_desc *cmd;
+	uint16_t tag = CMD_STREAM_NONE;
+	int nargs = s->argc - 1;
+
+	if (s->state == STREAM_NAME) {
+		name_end(s);
+	}
+
+	if (s->state == STREAM_START || s->state == STREAM_GIVE_UP ||
+	    s->quote != '\0' || s->escape || s->argc > CMD_ARGC_MAX) {
+		/* empty, or left to cmd_parse() to report */
+	} else if (s->cmd < 0) {
+		tag = CMD_STREAM_UNKNOWN;
+	} else {
+		STRUCT_SECTION_GET(cmd_desc, s->cmd, &cmd);
+		if (nargs >= cmd->min_args && nargs <= cmd->max_args) {
+			tag = s->cmd + 1;
+		}
+	}
+
+	cmd_stream_reset(s);
+
+	return tag;
+}
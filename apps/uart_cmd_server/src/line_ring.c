@@ -0,0 +1,222 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "line_ring.h"
+
+#include <string.h>
+
+#define LINE_RING_MASK (LINE_RING_SIZE - 1)
+
+/* length prefix of a line moved to the start of the buffer */
+#define LINE_RING_WRAP 0xFFFF
+
+/* tag field of a line once the consumer has it: held or released */
+#define LINE_RING_HELD 0
+#define LINE_RING_FREE 1
+
+BUILD_ASSERT((LINE_RING_SIZE & LINE_RING_MASK) == 0,
+	     "CONFIG_CMD_SERVER_RX_RING_SIZE must be a power of two");
+BUILD_ASSERT(LINE_RING_SIZE >= 2 * (LINE_RING_HDR_SIZE + LINE_RING_LINE_MAX + 1),
+	     "CONFIG_CMD_SERVER_RX_RING_SIZE too small for CONFIG_CMD_SERVER_LINE_MAX");
+BUILD_ASSERT(LINE_RING_LINE_MAX < LINE_RING_WRAP,
+	     "CONFIG_CMD_SERVER_LINE_MAX does not fit the length prefix");
+
+/*
+ * Position at which a line starting at pos is actually stored: if there is
+ * no room before the end of the buffer for a length prefix, a byte and the
+ * terminator, the line starts at the beginning instead. Producer and
+ * consumer both derive this from the index alone.
+ */
+static inline uint32_t line_pos(uint32_t pos)
+{
+	uint32_t room = LINE_RING_SIZE - (pos & LINE_RING_MASK);
+
+	return (room < LINE_RING_HDR_SIZE + 2) ? pos + room : pos;
+}
+
+static inline void hdr_set(struct line_ring *ring, uint32_t pos, uint16_t val)
+{
+	ring->buf[pos & LINE_RING_MASK] = (char)(val & 0xFF);
+	ring->buf[(pos + 1) & LINE_RING_MASK] = (char)(val >> 8);
+}
+
+static inline void hdr_set32(struct line_ring *ring, uint32_t pos, uint32_t val)
+{
+	hdr_set(ring, pos, val & 0xFFFF);
+	hdr_set(ring, pos + 2, val >> 16);
+}
+
+static inline uint16_t hdr_get(const struct line_ring *ring, uint32_t pos)
+{
+	return (uint8_t)ring->buf[pos & LINE_RING_MASK] |
+	       ((uint8_t)ring->buf[(pos + 1) & LINE_RING_MASK] << 8);
+}
+
+/* Drop the open line up to the next line end. */
+static void line_drop(struct line_ring *ring)
+{
+	ring->head = ring->line_start;
+	ring->discard = true;
+	atomic_inc(&ring->dropped);
+}
+
+void line_ring_init(struct line_ring *ring)
+{
+	ring->head = 0;
+	ring->line_start = 0;
+	ring->discard = false;
+	ring->read = 0;
+	atomic_set(&ring->tail, 0);
+	atomic_set(&ring->dropped, 0);
+	k_sem_init(&ring->lines, 0, K_SEM_MAX_LIMIT);
+}
+
+void line_ring_put(struct line_ring *ring, char c)
+{
+	uint32_t tail = (uint32_t)atomic_get(&ring->tail);
+	uint32_t len;
+
+	if (ring->discard) {
+		return;
+	}
+
+	if (ring->head == ring->line_start) {
+		/* first byte of a line, reserve its length prefix */
+		ring->line_start = line_pos(ring->head);
+		ring->head = ring->line_start + LINE_RING_HDR_SIZE;
+	}
+
+	len = ring->head - ring->line_start - LINE_RING_HDR_SIZE;
+	if (len == LINE_RING_LINE_MAX) {
+		line_drop(ring);
+		return;
+	}
+
+	if ((ring->head & LINE_RING_MASK) == LINE_RING_MASK) {
+		/*
+		 * No room left for the terminator after this byte: move the
+		 * line to the start of the buffer and leave a wrap marker.
+		 */
+		uint32_t start = ring->head + 1;
+
+		if (start + LINE_RING_HDR_SIZE + len + 2 - tail > LINE_RING_SIZE) {
+			line_drop(ring);
+			return;
+		}
+
+		memcpy(&ring->buf[LINE_RING_HDR_SIZE],
+		       &ring->buf[(ring->line_start + LINE_RING_HDR_SIZE) & LINE_RING_MASK],
+		       len);
+		hdr_set(ring, ring->line_start, LINE_RING_WRAP);
+
+		ring->line_start = start;
+		ring->head = start + LINE_RING_HDR_SIZE + len;
+	}
+
+	/* the byte and the terminator must fit in front of the consumer */
+	if (ring->head + 2 - tail > LINE_RING_SIZE) {
+		line_drop(ring);
+		return;
+	}
+
+	ring->buf[ring->head & LINE_RING_MASK] = c;
+	ring->head++;
+}
+
+void line_ring_commit(struct line_ring *ring, uint16_t tag)
+{
+	if (ring->discard) {
+		ring->discard = false;
+		ring->head = ring->line_start;
+		return;
+	}
+
+	if (ring->head == ring->line_start) {
+		return;
+	}
+
+	/* room for the terminator was reserved by line_ring_put() */
+	ring->buf[ring->head & LINE_RING_MASK] = '\0';
+	hdr_set(ring, ring->line_start,
+		ring->head - ring->line_start - LINE_RING_HDR_SIZE);
+	hdr_set(ring, ring->line_start + 2, tag);
+#ifdef CONFIG_CMD_LATENCY
+	hdr_set32(ring, ring->line_start + 4, ring->stamp_isr);
+	hdr_set32(ring, ring->line_start + 8, k_cycle_get_32());
+#endif
+	ring->head++;
+	ring->line_start = ring->head;
+
+	k_sem_give(&ring->lines);
+}
+
+void line_ring_abort(struct line_ring *ring)
+{
+	ring->discard = false;
+	ring->head = ring->line_start;
+}
+
+/* Header of the first line stored at or after pos, past a wrap marker. */
+static uint32_t line_hdr(const struct line_ring *ring, uint32_t pos)
+{
+	uint32_t start = line_pos(pos);
+
+	if (hdr_get(ring, start) == LINE_RING_WRAP) {
+		/* the line was moved to the start of the buffer */
+		start = (start | LINE_RING_MASK) + 1;
+	}
+
+	return start;
+}
+
+char *line_ring_get(struct line_ring *ring, size_t *len, uint16_t *tag,
+		    k_timeout_t timeout)
+{
+	k_spinlock_key_t key;
+	uint32_t start;
+
+	if (k_sem_take(&ring->lines, timeout) != 0) {
+		return NULL;
+	}
+
+	start = line_hdr(ring, ring->read);
+
+	*len = hdr_get(ring, start);
+	*tag = hdr_get(ring, start + 2);
+
+	/*
+	 * From now on the tag field tracks whether the line is still held.
+	 * Releases only look at lines before read, so the line is marked
+	 * before they can see it.
+	 */
+	key = k_spin_lock(&ring->release_lock);
+	hdr_set(ring, start + 2, LINE_RING_HELD);
+	ring->read = start + LINE_RING_HDR_SIZE + *len + 1;
+	k_spin_unlock(&ring->release_lock, key);
+
+	return &ring->buf[(start + LINE_RING_HDR_SIZE) & LINE_RING_MASK];
+}
+
+void line_ring_release(struct line_ring *ring, char *line)
+{
+	k_spinlock_key_t key = k_spin_lock(&ring->release_lock);
+	uint32_t tail = (uint32_t)atomic_get(&ring->tail);
+	uint32_t start;
+
+	/* the header sits right in front of the line and never wraps */
+	hdr_set(ring, line - ring->buf - LINE_RING_HDR_SIZE + 2, LINE_RING_FREE);
+
+	/* give back the room of the released lines from the oldest one on */
+	while (tail != ring->read) {
+		start = line_hdr(ring, tail);
+		if (hdr_get(ring, start + 2) != LINE_RING_FREE) {
+			break;
+		}
+		tail = start + LINE_RING_HDR_SIZE + hdr_get(ring, start) + 1;
+	}
+
+	atomic_set(&ring->tail, (atomic_val_t)tail);
+
+	k_spin_unlock(&ring->release_lock, key);
+}
@@ -0,0 +1,837 @@
+/*
+ * Copyright (c) 2022 Libre Solar Technologies GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/sys/ring_buffer.h>
+
+#include <string.h>
+
+#include "cmd_frame.h"
+#include "cmd_latency.h"
+#include "cmd_stream.h"
+#include "uart_handler.h"
+
+/* change this to any other UART peripheral if desired */
+#define UART_DEVICE_NODE DT_CHOSEN(zephyr_shell_uart)
+
+static const struct device *const uart_dev = DEVICE_DT_GET(UART_DEVICE_NODE);
+
+/* ring the received lines are framed into */
+static struct line_ring *rx_ring;
+
+/* baud rate and frame format assumed if the driver cannot report them */
+#define UART_DEFAULT_BAUDRATE 115200
+#define UART_DEFAULT_CHAR_BITS 10
+
+/*
+ * Idle time that ends a partial line, CONFIG_CMD_SERVER_RX_IDLE_CHARS
+ * character times at the current link speed; 0 if disabled.
+ */
+static uint32_t rx_idle_us;
+static uint32_t rx_idle_cyc;
+
+/*
+ * One-shot idle timer, armed once per burst by the RX callback. On expiry
+ * it compares the cycle counter against the time of the last chunk and
+ * either re-arms for the remainder or commits the partial line.
+ */
+static struct k_timer uart_rx_timer;
+static atomic_t rx_timer_armed;
+static atomic_t rx_last_cyc;
+
+/*
+ * Ownership of the partial line in rx_ring. The RX callback and the idle
+ * timer expiry both run in interrupt context and may preempt each other, so
+ * they hand the producer side of the ring over through this state instead
+ * of a kernel lock:
+ *
+ * RX_EMPTY:    no partial line, nobody owns the ring
+ * RX_OPEN:     a partial line is stored, nobody owns the ring
+ * RX_DRAINING: the RX callback owns the ring and is framing new bytes
+ * RX_FLUSHING: the timer owns the ring and is committing the partial line
+ * RX_DEFERRED: the RX callback preempted a flush and backed off; the timer
+ *              still owns the ring and picks up the work in rx_resume()
+ *
+ * Ownership is only taken with atomic_cas() and only released with
+ * atomic_cas()/atomic_set(). Zephyr atomics are sequentially consistent,
+ * so everything the previous owner wrote to the ring is visible to the next
+ * owner once it has observed the new state.
+ */
+enum rx_state {
+	RX_EMPTY,
+	RX_OPEN,
+	RX_DRAINING,
+	RX_FLUSHING,
+	RX_DEFERRED,
+};
+
+static atomic_t rx_state = ATOMIC_INIT(RX_EMPTY);
+
+/*
+ * Take ownership of the ring from the RX callback. Fails only if the idle
+ * timer is in the middle of a flush that this interrupt preempted.
+ */
+static bool rx_claim(void)
+{
+	atomic_val_t state;
+
+	do {
+		state = atomic_get(&rx_state);
+		if (state == RX_DEFERRED ||
+		    (state == RX_FLUSHING &&
+		     atomic_cas(&rx_state, RX_FLUSHING, RX_DEFERRED))) {
+			return false;
+		}
+	} while (state == RX_FLUSHING ||
+		 !atomic_cas(&rx_state, state, RX_DRAINING));
+
+	return true;
+}
+
+static void rx_release(void)
+{
+	atomic_set(&rx_state, line_ring_is_open(rx_ring) ? RX_OPEN : RX_EMPTY);
+}
+
+#ifdef CONFIG_CMD_SERVER_BINARY
+/*
+ * Binary frame mode. rx_binary is owned with the ring and only follows
+ * rx_binary_req, set by the main thread, between two lines or frames.
+ */
+static atomic_t rx_binary_req;
+static bool rx_binary;
+static struct cmd_frame_dec rx_dec;
+#endif
+
+static inline bool rx_is_binary(void)
+{
+#ifdef CONFIG_CMD_SERVER_BINARY
+	return rx_binary;
+#else
+	return false;
+#endif
+}
+
+/*
+ * Note the arrival of data and make sure the idle timer runs for the current
+ * burst. Called by the RX callback after framing, so that an expiry which
+ * found the callback busy and disarmed the timer is always followed by a
+ * new arm.
+ */
+static void rx_idle_restart(void)
+{
+	if (rx_idle_cyc == 0 || !line_ring_is_open(rx_ring) || rx_is_binary()) {
+		return;
+	}
+
+	atomic_set(&rx_last_cyc, (atomic_val_t)k_cycle_get_32());
+
+	if (atomic_cas(&rx_timer_armed, 0, 1)) {
+		k_timer_start(&uart_rx_timer, K_CYC(rx_idle_cyc), K_NO_WAIT);
+	}
+}
+
+#ifdef CONFIG_CMD_LATENCY
+/* entry of the current RX interrupt, stamped on the lines it starts */
+static uint32_t rx_isr_cyc;
+#endif
+
+#ifdef CONFIG_CMD_STREAM_PARSE
+/* resolves the command of the open line as it arrives, owned with the ring */
+static struct cmd_stream rx_stream;
+#endif
+
+/* Hand the open line to the consumer. Must be called with the ring owned. */
+static void rx_commit(void)
+{
+#ifdef CONFIG_CMD_STREAM_PARSE
+	line_ring_commit(rx_ring, cmd_stream_end(&rx_stream));
+#else
+	line_ring_commit(rx_ring, CMD_STREAM_NONE);
+#endif
+}
+
+/* End the open line because the RX line went idle. */
+static void rx_idle_commit(void)
+{
+	/* binary frames only end at their delimiter */
+	if (!rx_is_binary()) {
+		rx_commit();
+	}
+}
+
+#ifdef CONFIG_CMD_SERVER_BINARY
+/*
+ * Decode one byte of a COBS frame straight into the ring. Frames that fail
+ * the CRC or length check are thrown away when their delimiter arrives.
+ */
+static void rx_frame_binary(uint8_t b)
+{
+	uint8_t out;
+
+	switch (cmd_frame_dec_byte(&rx_dec, b, &out)) {
+	case CMD_FRAME_RX_BYTE:
+		line_ring_put(rx_ring, out);
+		break;
+	case CMD_FRAME_RX_END:
+		line_ring_commit(rx_ring, CMD_FRAME_TAG);
+		break;
+	case CMD_FRAME_RX_BAD:
+		line_ring_abort(rx_ring);
+		break;
+	default:
+		break;
+	}
+}
+
+/* Apply a mode switch requested by the main thread between two frames. */
+static inline void rx_mode_sync(void)
+{
+	bool binary = atomic_get(&rx_binary_req) != 0;
+
+	if (binary != rx_binary && !line_ring_is_open(rx_ring)) {
+		rx_binary = binary;
+		cmd_frame_dec_reset(&rx_dec);
+	}
+}
+#endif /* CONFIG_CMD_SERVER_BINARY */
+
+/*
+ * Line framer shared by both RX backends: split received bytes into lines
+ * at '\r' or '\n', or into binary frames at 0x00 in binary mode. Must be
+ * called with the ring owned.
+ */
+static void rx_frame(const uint8_t *data, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+#ifdef CONFIG_CMD_SERVER_BINARY
+		rx_mode_sync();
+		if (rx_binary) {
+			rx_frame_binary(data[i]);
+			continue;
+		}
+#endif
+		if (data[i] == '\n' || data[i] == '\r') {
+			rx_commit();
+		} else {
+#ifdef CONFIG_CMD_LATENCY
+			line_ring_stamp_isr(rx_ring, rx_isr_cyc);
+#endif
+			/* lines longer than LINE_RING_LINE_MAX are dropped */
+			line_ring_put(rx_ring, data[i]);
+#ifdef CONFIG_CMD_STREAM_PARSE
+			cmd_stream_feed(&rx_stream, data[i]);
+#endif
+		}
+	}
+}
+
+/*
+ * Transmit ring, filled by uart_write() from any thread and drained by the
+ * UART interrupt or the asynchronous TX callback. tx_lock serialises the
+ * writers against each other and against the drain.
+ */
+RING_BUF_DECLARE(tx_ring, CONFIG_CMD_SERVER_TX_RING_SIZE);
+static struct k_spinlock tx_lock;
+
+/* given whenever the drain has made room in tx_ring */
+static K_SEM_DEFINE(tx_space, 0, 1);
+
+/* completion semaphores waiting for the drain to pass a byte count */
+#define TX_NOTIFY_COUNT 4
+
+struct tx_notify {
+	uint32_t mark;
+	struct k_sem *sem;
+};
+
+static struct tx_notify tx_notify[TX_NOTIFY_COUNT];
+static uint32_t tx_notify_head;
+static uint32_t tx_notify_tail;
+
+/* bytes accepted by uart_write() and bytes handed to the UART */
+static uint32_t tx_written;
+static uint32_t tx_sent;
+
+/* Account for len bytes handed to the UART. Must hold tx_lock. */
+static void tx_done(uint32_t len)
+{
+	ring_buf_get_finish(&tx_ring, len);
+	tx_sent += len;
+
+	while (tx_notify_tail != tx_notify_head) {
+		struct tx_notify *n = &tx_notify[tx_notify_tail % TX_NOTIFY_COUNT];
+
+		if ((int32_t)(tx_sent - n->mark) < 0) {
+			break;
+		}
+		k_sem_give(n->sem);
+		tx_notify_tail++;
+	}
+
+#ifdef CONFIG_CMD_LATENCY
+	cmd_lat_tx_sent(tx_sent);
+#endif
+
+	k_sem_give(&tx_space);
+}
+
+static void tx_kick(void);
+
+#ifdef CONFIG_CMD_SERVER_UART_ASYNC
+
+#define RX_BUF_COUNT CONFIG_CMD_SERVER_UART_ASYNC_BUF_COUNT
+#define RX_BUF_SIZE  CONFIG_CMD_SERVER_UART_ASYNC_BUF_SIZE
+
+/*
+ * Longest inactivity, in character times, after which the driver must
+ * report a partially filled buffer so that line ends are seen promptly.
+ */
+#define RX_CHUNK_CHARS 8
+
+/* inactivity passed to uart_rx_enable() */
+static int32_t rx_chunk_timeout_us;
+
+/*
+ * True if the driver's RX timeout equals the idle time, so that every
+ * UART_RX_RDY for a partially filled buffer marks an idle line. The timer
+ * then only covers chunks that end exactly at the end of a buffer, which
+ * the driver reports as full and not again once the line goes idle.
+ */
+static bool rx_hw_idle;
+
+/* buffers handed to the driver in turn; it fills one while we read another */
+static uint8_t rx_bufs[RX_BUF_COUNT][RX_BUF_SIZE];
+static uint8_t rx_buf_next;
+
+/* chunk received while the timer owned the ring, framed by the next owner */
+static const uint8_t *rx_stash;
+static size_t rx_stash_len;
+
+static void rx_frame_stash(void)
+{
+	size_t len = rx_stash_len;
+
+	if (len > 0) {
+		rx_frame(rx_stash, len);
+		rx_stash_len = 0;
+	}
+}
+
+/*
+ * Called from the timer with the ring still owned after the RX callback
+ * backed off. Interrupts nest on a single CPU, so the callback has already
+ * stashed its chunk by the time the timer runs again.
+ */
+static void rx_resume(void)
+{
+	do {
+		rx_frame_stash();
+		rx_idle_restart();
+		rx_release();
+	} while (rx_stash_len != 0 && rx_claim());
+}
+
+static void rx_chunk(const uint8_t *data, size_t len, bool idle)
+{
+	if (!rx_claim()) {
+		if (rx_stash_len == 0) {
+			rx_stash = data;
+			rx_stash_len = len;
+		} else {
+			/* second chunk during a single flush, cannot keep it */
+			atomic_inc(&rx_ring->dropped);
+		}
+		return;
+	}
+
+	rx_frame_stash();
+	rx_frame(data, len);
+
+	if (idle && rx_hw_idle) {
+		/* the driver saw the line go idle, end the frame here */
+		rx_idle_commit();
+	} else {
+		/* with rx_hw_idle, only a full buffer gets here */
+		rx_idle_restart();
+	}
+
+	rx_release();
+}
+
+/* set while a uart_tx() transfer is in flight */
+static atomic_t tx_busy;
+
+/*
+ * Start a transfer of the next contiguous block of tx_ring unless one is
+ * already in flight. Rechecks after going idle so that a write racing with
+ * the end of the previous transfer is not left behind.
+ */
+static void tx_kick(void)
+{
+	k_spinlock_key_t key;
+	uint8_t *data;
+	uint32_t len;
+
+	while (atomic_cas(&tx_busy, 0, 1)) {
+		key = k_spin_lock(&tx_lock);
+		len = ring_buf_get_claim(&tx_ring, &data, UINT32_MAX);
+		k_spin_unlock(&tx_lock, key);
+
+		if (len > 0 &&
+		    uart_tx(uart_dev, data, len, SYS_FOREVER_US) == 0) {
+			return;
+		}
+
+		if (len > 0) {
+			/* the driver refused the transfer, drop the data */
+			key = k_spin_lock(&tx_lock);
+			tx_done(len);
+			k_spin_unlock(&tx_lock, key);
+		}
+
+		atomic_set(&tx_busy, 0);
+
+		if (ring_buf_is_empty(&tx_ring)) {
+			return;
+		}
+	}
+}
+
+static int rx_start(void)
+{
+	rx_buf_next = 1 % RX_BUF_COUNT;
+
+	return uart_rx_enable(uart_dev, rx_bufs[0], RX_BUF_SIZE,
+			      rx_chunk_timeout_us);
+}
+
+/*
+ * Asynchronous UART callback: received chunks go straight to the line
+ * framer and the driver is kept supplied with the next buffer in turn.
+ */
+static void uart_async_cb(const struct device *dev, struct uart_event *evt,
+			  void *user_data)
+{
+	k_spinlock_key_t key;
+
+	switch (evt->type) {
+	case UART_TX_DONE:
+	case UART_TX_ABORTED:
+		key = k_spin_lock(&tx_lock);
+		tx_done(evt->data.tx.len);
+		k_spin_unlock(&tx_lock, key);
+
+		atomic_set(&tx_busy, 0);
+		tx_kick();
+		break;
+
+	case UART_RX_RDY:
+#ifdef CONFIG_CMD_LATENCY
+		rx_isr_cyc = k_cycle_get_32();
+#endif
+		/* a buffer reported before it is full was ended by the RX timeout */
+		rx_chunk(evt->data.rx.buf + evt->data.rx.offset,
+			 evt->data.rx.len,
+			 evt->data.rx.offset + evt->data.rx.len < RX_BUF_SIZE);
+		break;
+
+	case UART_RX_BUF_REQUEST:
+		uart_rx_buf_rsp(dev, rx_bufs[rx_buf_next], RX_BUF_SIZE);
+		rx_buf_next = (rx_buf_next + 1) % RX_BUF_COUNT;
+		break;
+
+	case UART_RX_DISABLED:
+		/* the driver gave up after an error or ran out of buffers */
+		rx_start();
+		break;
+
+	default:
+		break;
+	}
+}
+
+static int rx_init(uint32_t char_us)
+{
+	int ret;
+
+	/* let the driver's RX timeout detect idle if it is short enough */
+	rx_chunk_timeout_us = MAX(char_us * RX_CHUNK_CHARS, 1);
+	if (rx_idle_us != 0 && rx_idle_us <= rx_chunk_timeout_us) {
+		rx_chunk_timeout_us = rx_idle_us;
+		rx_hw_idle = true;
+		/*
+		 * After a full buffer the timer waits until the driver must have
+		 * reported the next one, full or timed out, had any byte arrived.
+		 * Expiry then means the line has been idle since the full buffer.
+		 */
+		rx_idle_cyc = MIN(k_us_to_cyc_ceil64(rx_idle_us + (uint64_t)char_us * RX_BUF_SIZE),
+				  UINT32_MAX / 2);
+	}
+
+	ret = uart_callback_set(uart_dev, uart_async_cb, NULL);
+	if (ret < 0) {
+		if (ret == -ENOTSUP) {
+			printk("Asynchronous UART API support not enabled\n");
+		} else if (ret == -ENOSYS) {
+			printk("UART device does not support asynchronous API\n");
+		} else {
+			printk("Error setting UART callback: %d\n", ret);
+		}
+		return ret;
+	}
+
+	ret = rx_start();
+	if (ret < 0) {
+		printk("Error enabling UART RX: %d\n", ret);
+	}
+
+	return ret;
+}
+
+#else /* CONFIG_CMD_SERVER_UART_ASYNC */
+
+/* bytes taken from the FIFO per read */
+#define RX_FIFO_CHUNK 16
+
+/*
+ * Called from the timer with the ring still owned after serial_cb() backed
+ * off and masked RX. Release first so the pending interrupt can claim it.
+ */
+static void rx_resume(void)
+{
+	rx_release();
+	uart_irq_rx_enable(uart_dev);
+}
+
+/* the TX interrupt drains tx_ring; enabling it is enough to start */
+static void tx_kick(void)
+{
+	uart_irq_tx_enable(uart_dev);
+}
+
+/*
+ * Fill the TX FIFO from tx_ring, and stop the TX interrupt once the ring
+ * is empty.
+ */
+static void serial_tx(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&tx_lock);
+	uint8_t *data;
+	uint32_t len = ring_buf_get_claim(&tx_ring, &data, UINT32_MAX);
+	int sent;
+
+	if (len == 0) {
+		uart_irq_tx_disable(uart_dev);
+		k_spin_unlock(&tx_lock, key);
+		return;
+	}
+
+	sent = uart_fifo_fill(uart_dev, data, len);
+	tx_done(MAX(sent, 0));
+
+	k_spin_unlock(&tx_lock, key);
+}
+
+/*
+ * Read characters from UART into the line ring until line end is detected,
+ * then hand the line over to the consumer.
+ * If the UART line then remains idle, the timer hands over the partial line
+ * instead.
+ */
+static void serial_rx(void)
+{
+	uint8_t buf[RX_FIFO_CHUNK];
+	int len;
+
+	if (!rx_claim()) {
+		/* leave the bytes in the FIFO until the flush is done */
+		uart_irq_rx_disable(uart_dev);
+		return;
+	}
+
+	/* read until FIFO empty */
+	while ((len = uart_fifo_read(uart_dev, buf, sizeof(buf))) > 0) {
+		rx_frame(buf, len);
+	}
+
+	rx_idle_restart();
+	rx_release();
+}
+
+static void serial_cb(const struct device *dev, void *user_data)
+{
+#ifdef CONFIG_CMD_LATENCY
+	rx_isr_cyc = k_cycle_get_32();
+#endif
+
+	if (!uart_irq_update(uart_dev)) {
+		return;
+	}
+
+	if (uart_irq_rx_ready(uart_dev)) {
+		serial_rx();
+	}
+
+	if (uart_irq_tx_ready(uart_dev)) {
+		serial_tx();
+	}
+}
+
+static int rx_init(uint32_t char_us)
+{
+	ARG_UNUSED(char_us);
+
+	/* configure interrupt and callback to receive data */
+	int ret = uart_irq_callback_user_data_set(uart_dev, serial_cb, NULL);
+
+	if (ret < 0) {
+		if (ret == -ENOTSUP) {
+			printk("Interrupt-driven UART API support not enabled\n");
+		} else if (ret == -ENOSYS) {
+			printk("UART device does not support interrupt-driven API\n");
+		} else {
+			printk("Error setting UART callback: %d\n", ret);
+		}
+		return ret;
+	}
+	uart_irq_rx_enable(uart_dev);
+
+	return 0;
+}
+
+#endif /* CONFIG_CMD_SERVER_UART_ASYNC */
+
+/*
+ * Commit the partial line, if any, once no data has arrived for the idle
+ * time. If the RX callback is busy with new bytes right now it re-arms the
+ * timer when it is done.
+ */
+static void uart_timer_expiry_func(struct k_timer *timer_id)
+{
+	uint32_t elapsed;
+
+	if (!atomic_cas(&rx_state, RX_OPEN, RX_FLUSHING)) {
+		atomic_set(&rx_timer_armed, 0);
+		return;
+	}
+
+	/* the ring is owned, so the RX callback cannot update this now */
+	elapsed = k_cycle_get_32() - (uint32_t)atomic_get(&rx_last_cyc);
+
+	if (elapsed < rx_idle_cyc) {
+		/* more data arrived since the timer was armed */
+		k_timer_start(&uart_rx_timer, K_CYC(rx_idle_cyc - elapsed),
+			      K_NO_WAIT);
+	} else {
+		atomic_set(&rx_timer_armed, 0);
+		rx_idle_commit();
+	}
+
+	if (!atomic_cas(&rx_state, RX_FLUSHING,
+			line_ring_is_open(rx_ring) ? RX_OPEN : RX_EMPTY)) {
+		/* the RX callback ran meanwhile and backed off */
+		rx_resume();
+	}
+}
+
+/* Track a completion for everything written so far. Must hold tx_lock. */
+static void tx_notify_add(struct k_sem *done)
+{
+	tx_notify[tx_notify_head % TX_NOTIFY_COUNT] = (struct tx_notify){
+		.mark = tx_written,
+		.sem = done,
+	};
+	tx_notify_head++;
+}
+
+static bool tx_notify_full(void)
+{
+	return tx_notify_head - tx_notify_tail == TX_NOTIFY_COUNT;
+}
+
+int uart_write(const void *buf, size_t len, struct k_sem *done)
+{
+	k_spinlock_key_t key = k_spin_lock(&tx_lock);
+	uint32_t accepted;
+
+	if (done != NULL && tx_notify_full()) {
+		k_spin_unlock(&tx_lock, key);
+		return -EBUSY;
+	}
+
+	accepted = ring_buf_put(&tx_ring, buf, len);
+	tx_written += accepted;
+
+	if (done != NULL && accepted > 0) {
+		tx_notify_add(done);
+	}
+
+	k_spin_unlock(&tx_lock, key);
+
+	if (accepted > 0) {
+		tx_kick();
+	}
+
+	return accepted;
+}
+
+/* uart_writev(), also returning the TX stream position after the data */
+static int tx_writev(const struct uart_iov *iov, size_t iovcnt,
+		     struct k_sem *done, uint32_t *mark)
+{
+	k_spinlock_key_t key;
+	size_t total = 0;
+
+	for (size_t i = 0; i < iovcnt; i++) {
+		total += iov[i].len;
+	}
+
+	if (total > ring_buf_size_get(&tx_ring)) {
+		return -EMSGSIZE;
+	}
+
+	key = k_spin_lock(&tx_lock);
+
+	if (ring_buf_space_get(&tx_ring) < total ||
+	    (done != NULL && tx_notify_full())) {
+		k_spin_unlock(&tx_lock, key);
+		return -EAGAIN;
+	}
+
+	/* room is reserved under the lock, so every fragment fits */
+	for (size_t i = 0; i < iovcnt; i++) {
+		ring_buf_put(&tx_ring, iov[i].base, iov[i].len);
+	}
+	tx_written += total;
+	*mark = tx_written;
+
+	if (done != NULL && total > 0) {
+		tx_notify_add(done);
+	}
+
+	k_spin_unlock(&tx_lock, key);
+
+	if (total > 0) {
+		tx_kick();
+	}
+
+	return total;
+}
+
+int uart_writev(const struct uart_iov *iov, size_t iovcnt, struct k_sem *done)
+{
+	uint32_t mark;
+
+	return tx_writev(iov, iovcnt, done, &mark);
+}
+
+uint32_t uart_tx_sent(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&tx_lock);
+	uint32_t sent = tx_sent;
+
+	k_spin_unlock(&tx_lock, key);
+
+	return sent;
+}
+
+void print_uart(const char *buf)
+{
+	size_t len = strlen(buf);
+	int ret;
+
+	while (len > 0) {
+		ret = uart_write(buf, len, NULL);
+		if (ret <= 0) {
+			/* ring full, wait for the drain to make room */
+			k_sem_take(&tx_space, K_FOREVER);
+			continue;
+		}
+		buf += ret;
+		len -= ret;
+	}
+}
+
+int print_uartv(const struct uart_iov *iov, size_t iovcnt, uint32_t *mark)
+{
+	uint32_t end;
+	int ret;
+
+	/* -EAGAIN: not enough room yet, wait for the drain */
+	while ((ret = tx_writev(iov, iovcnt, NULL, &end)) == -EAGAIN) {
+		k_sem_take(&tx_space, K_FOREVER);
+	}
+
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (mark != NULL) {
+		*mark = end;
+	}
+
+	return 0;
+}
+
+void uart_handler_set_binary(bool binary)
+{
+#ifdef CONFIG_CMD_SERVER_BINARY
+	atomic_set(&rx_binary_req, binary);
+#else
+	ARG_UNUSED(binary);
+#endif
+}
+
+/*
+ * Duration of one character on the wire in microseconds, including start,
+ * parity and stop bits.
+ */
+static uint32_t uart_char_us(void)
+{
+	struct uart_config cfg;
+	uint32_t baudrate = UART_DEFAULT_BAUDRATE;
+	uint32_t bits = UART_DEFAULT_CHAR_BITS;
+
+	if (uart_config_get(uart_dev, &cfg) == 0 && cfg.baudrate != 0) {
+		baudrate = cfg.baudrate;
+		/* start bit, data bits and parity bit */
+		bits = 1 + (cfg.data_bits - UART_CFG_DATA_BITS_5 + 5) +
+		       (cfg.parity != UART_CFG_PARITY_NONE ? 1 : 0);
+		/* 1.5 stop bits are rounded up */
+		bits += (cfg.stop_bits >= UART_CFG_STOP_BITS_1_5) ? 2 : 1;
+	}
+
+	return DIV_ROUND_UP(bits * 1000000U, baudrate);
+}
+
+int uart_handler_init(struct line_ring *ring)
+{
+	uint32_t char_us;
+
+	if (!device_is_ready(uart_dev)) {
+		printk("UART device not found!");
+		return -ENODEV;
+	}
+
+	rx_ring = ring;
+#ifdef CONFIG_CMD_STREAM_PARSE
+	cmd_stream_reset(&rx_stream);
+#endif
+
+	char_us = uart_char_us();
+	/* 65535 characters at 110 baud take longer than 2^32 us */
+	rx_idle_us = MIN((uint64_t)CONFIG_CMD_SERVER_RX_IDLE_CHARS * char_us, UINT32_MAX);
+	/* elapsed time is measured with the 32-bit cycle counter */
+	rx_idle_cyc = MIN(k_us_to_cyc_ceil64(rx_idle_us), UINT32_MAX / 2);
+
+	/* initialize software timer before the first byte can arrive */
+	k_timer_init(&uart_rx_timer, uart_timer_expiry_func, NULL);
+
+	return rx_init(char_us);
+}
@@ -0,0 +1,170 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/ztest.h>
+
+#include <string.h>
+
+#include "cmd_parser.h"
+
+BUILD_ASSERT(CMD_ARGC_MAX == 4, "the cases below assume four arguments at most");
+
+static char line[64];
+static struct cmd_args args;
+static struct cmd_span err_span;
+
+/* Parse a copy of text, which cmd_parse() modifies in place. */
+static void parse(const char *text, enum cmd_parse_error expect)
+{
+	size_t len = strlen(text);
+	enum cmd_parse_error err;
+
+	zassert_true(len < sizeof(line), "test line too long");
+	memcpy(line, text, len + 1);
+	memset(&args, 0xa5, sizeof(args));
+	err_span = (struct cmd_span){ 0xffff, 0xffff };
+
+	err = cmd_parse(line, len, &args, &err_span);
+	zassert_equal(err, expect, "'%s': %s, expected %s", text, cmd_parse_strerror(err),
+		      cmd_parse_strerror(expect));
+}
+
+static void assert_span(const struct cmd_span *span, uint16_t start, uint16_t len)
+{
+	zassert_equal(span->start, start, "span starts at %u, expected %u", span->start,
+		      start);
+	zassert_equal(span->len, len, "span is %u long, expected %u", span->len, len);
+}
+
+ZTEST(cmd_parser, test_words)
+{
+	parse("led on", CMD_PARSE_OK);
+	zassert_equal(args.argc, 2);
+	zassert_str_equal(args.argv[0], "led");
+	zassert_str_equal(args.argv[1], "on");
+	zassert_is_null(args.argv[2]);
+}
+
+ZTEST(cmd_parser, test_whitespace)
+{
+	parse("  \tcount \t  5\t ", CMD_PARSE_OK);
+	zassert_equal(args.argc, 2);
+	zassert_str_equal(args.argv[0], "count");
+	zassert_str_equal(args.argv[1], "5");
+	zassert_is_null(args.argv[2]);
+}
+
+ZTEST(cmd_parser, test_single_quotes)
+{
+	/* no escapes or splitting inside single quotes */
+	parse("echo 'a  b\\n' x", CMD_PARSE_OK);
+	zassert_equal(args.argc, 3);
+	zassert_str_equal(args.argv[1], "a  b\\n");
+	zassert_str_equal(args.argv[2], "x");
+}
+
+ZTEST(cmd_parser, test_double_quotes)
+{
+	parse("echo \"a 'b'\\t\" \"\"", CMD_PARSE_OK);
+	zassert_equal(args.argc, 3);
+	zassert_str_equal(args.argv[1], "a 'b'\t");
+	/* an empty pair of quotes is still a token */
+	zassert_str_equal(args.argv[2], "");
+}
+
+ZTEST(cmd_parser, test_adjacent_parts)
+{
+	parse("a'b c'\"d\"e", CMD_PARSE_OK);
+	zassert_equal(args.argc, 1);
+	zassert_str_equal(args.argv[0], "ab cde");
+}
+
+ZTEST(cmd_parser, test_escapes)
+{
+	parse("x a\\ b \\\\ \\\"", CMD_PARSE_OK);
+	zassert_equal(args.argc, 4);
+	zassert_str_equal(args.argv[1], "a b");
+	zassert_str_equal(args.argv[2], "\\");
+	zassert_str_equal(args.argv[3], "\"");
+}
+
+ZTEST(cmd_parser, test_control_escapes)
+{
+	parse("\\r\\n\\t\\q", CMD_PARSE_OK);
+	zassert_equal(args.argc, 1);
+	zassert_str_equal(args.argv[0], "\r\n\tq");
+}
+
+ZTEST(cmd_parser, test_spans)
+{
+	/* spans cover the tokens as received, quotes and escapes included */
+	parse(" led  'o n' a\\ b", CMD_PARSE_OK);
+	zassert_equal(args.argc, 3);
+	assert_span(&args.span[0], 1, 3);
+	assert_span(&args.span[1], 6, 5);
+	assert_span(&args.span[2], 12, 4);
+}
+
+ZTEST(cmd_parser, test_too_many_args)
+{
+	parse("a b c d", CMD_PARSE_OK);
+	zassert_equal(args.argc, CMD_ARGC_MAX);
+	zassert_is_null(args.argv[CMD_ARGC_MAX]);
+
+	/* the span runs from the first extra token to the end of the line */
+	parse("a b c d  e f", CMD_PARSE_TOO_MANY_ARGS);
+	assert_span(&err_span, 9, 3);
+
+	/* trailing whitespace is not a token */
+	parse("a b c d  ", CMD_PARSE_OK);
+}
+
+ZTEST(cmd_parser, test_open_quote)
+{
+	/* the span runs from the start of the token to the end of the line */
+	parse("echo x\"a b", CMD_PARSE_OPEN_QUOTE);
+	assert_span(&err_span, 5, 5);
+
+	/* an escaped quote does not close */
+	parse("echo \"a\\\"", CMD_PARSE_OPEN_QUOTE);
+	assert_span(&err_span, 5, 4);
+}
+
+ZTEST(cmd_parser, test_trailing_escape)
+{
+	parse("echo ab\\", CMD_PARSE_TRAILING_ESCAPE);
+	assert_span(&err_span, 7, 1);
+
+	/* also inside double quotes */
+	parse("echo \"a\\", CMD_PARSE_TRAILING_ESCAPE);
+	assert_span(&err_span, 7, 1);
+}
+
+ZTEST(cmd_parser, test_empty_line)
+{
+	parse("", CMD_PARSE_OK);
+	zassert_equal(args.argc, 0);
+	zassert_is_null(args.argv[0]);
+
+	parse(" \t ", CMD_PARSE_OK);
+	zassert_equal(args.argc, 0);
+	zassert_is_null(args.argv[0]);
+}
+
+ZTEST(cmd_parser, test_no_err_span)
+{
+	char text[] = "'open";
+
+	zassert_equal(cmd_parse(text, strlen(text), &args, NULL), CMD_PARSE_OPEN_QUOTE);
+}
+
+ZTEST(cmd_parser, test_strerror)
+{
+	zassert_str_equal(cmd_parse_strerror(CMD_PARSE_OK), "no error");
+	zassert_str_equal(cmd_parse_strerror(CMD_PARSE_OPEN_QUOTE), "unterminated quote");
+	zassert_str_equal(cmd_parse_strerror((enum cmd_parse_error)99),
+			  "invalid command line");
+}
+
+ZTEST_SUITE(cmd_parser, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,211 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/serial/uart_emul.h>
+#include <zephyr/ztest.h>
+
+#include <string.h>
+
+#include "line_ring.h"
+#include "uart_handler.h"
+
+/*
+ * Drives the asynchronous RX path of uart_handler.c through the emulated
+ * UART: bytes put into its RX FIFO reach the server's callback as
+ * UART_RX_RDY chunks, and full buffers are replaced through
+ * UART_RX_BUF_REQUEST.
+ */
+
+#define RX_BUF_SIZE CONFIG_CMD_SERVER_UART_ASYNC_BUF_SIZE
+#define RX_BUF_COUNT CONFIG_CMD_SERVER_UART_ASYNC_BUF_COUNT
+
+/* one character at 115200 8N1, rounded up as uart_handler.c does */
+#define CHAR_US 87
+#define IDLE_MS DIV_ROUND_UP(CONFIG_CMD_SERVER_RX_IDLE_CHARS * CHAR_US, 1000)
+
+/* the driver's RX timeout ends idle lines, see rx_init() */
+#define DRIVER_IDLE (CONFIG_CMD_SERVER_RX_IDLE_CHARS <= 8)
+
+/* time for the emulator to report what it was given, a few ticks */
+#define SETTLE_MS 20
+
+/* time to fill an RX buffer, the timer's grace after a full one */
+#define BUF_FILL_MS DIV_ROUND_UP(RX_BUF_SIZE * CHAR_US, 1000)
+
+static const struct device *const uart = DEVICE_DT_GET(DT_CHOSEN(zephyr_shell_uart));
+
+static struct line_ring rx_ring;
+
+/* bytes fed so far; the driver fills the RX buffers back to back */
+static size_t rx_fed;
+
+static void feed(const char *text)
+{
+	size_t len = strlen(text);
+
+	zassert_equal(uart_emul_put_rx_data(uart, (const uint8_t *)text, len), len,
+		      "RX FIFO full");
+	rx_fed += len;
+}
+
+static void expect_line(const char *text, k_timeout_t timeout)
+{
+	size_t len;
+	uint16_t tag;
+	char *line = line_ring_get(&rx_ring, &len, &tag, timeout);
+
+	bool match;
+
+	zassert_not_null(line, "no line, expected '%s'", text);
+	match = (len == strlen(text) && strcmp(line, text) == 0);
+	/* released first, a failed case must not hold on to ring space */
+	line_ring_release(&rx_ring, line);
+	zassert_true(match, "wrong line of %zu bytes, expected '%s'", len, text);
+}
+
+static void expect_no_line(void)
+{
+	size_t len;
+	uint16_t tag;
+	char *line = line_ring_get(&rx_ring, &len, &tag, K_NO_WAIT);
+
+	if (line != NULL) {
+		line_ring_release(&rx_ring, line);
+	}
+	zassert_is_null(line, "unexpected line of %zu bytes", len);
+}
+
+ZTEST(uart_async, test_line_end)
+{
+	feed("status\r");
+	expect_line("status", K_MSEC(SETTLE_MS));
+
+	/* CR LF ends the line once, the empty second line is skipped */
+	feed("led on\r\ncount\n");
+	expect_line("led on", K_MSEC(SETTLE_MS));
+	expect_line("count", K_MSEC(SETTLE_MS));
+	expect_no_line();
+}
+
+ZTEST(uart_async, test_split_chunks)
+{
+	if (DRIVER_IDLE) {
+		/* the gap between the chunks would end the line */
+		ztest_test_skip();
+	}
+
+	/* each part is reported in a UART_RX_RDY of its own */
+	feed("sta");
+	k_msleep(SETTLE_MS);
+	expect_no_line();
+
+	feed("t");
+	k_msleep(SETTLE_MS);
+	expect_no_line();
+
+	feed("us\r");
+	expect_line("status", K_MSEC(SETTLE_MS));
+}
+
+ZTEST(uart_async, test_buffer_rotation)
+{
+	static const char *const lines[] = {
+		/* longer than an RX buffer */
+		"echo 0123456789abcdefghijklmnopqrstuvwxyz",
+		"count",
+		"led off",
+		"delay 10",
+		"help status",
+		"queues",
+	};
+	char text[128] = "";
+
+	BUILD_ASSERT(RX_BUF_SIZE < 40, "the first line must span RX buffers");
+
+	for (size_t i = 0; i < ARRAY_SIZE(lines); i++) {
+		strcat(text, lines[i]);
+		strcat(text, "\r");
+	}
+	zassert_true(strlen(text) > 2 * RX_BUF_COUNT * RX_BUF_SIZE,
+		     "every buffer must be reused at least once");
+
+	/*
+	 * The driver fills the buffers in turn and asks for the next one each
+	 * time, so lines only come out whole if the buffers rotate in order.
+	 */
+	feed(text);
+
+	for (size_t i = 0; i < ARRAY_SIZE(lines); i++) {
+		expect_line(lines[i], K_MSEC(SETTLE_MS));
+	}
+	expect_no_line();
+}
+
+ZTEST(uart_async, test_idle_line_end)
+{
+	/* no line end, the RX line going idle ends it */
+	feed("led on");
+
+	if (!DRIVER_IDLE) {
+		k_msleep(IDLE_MS / 2);
+		expect_no_line();
+	}
+
+	expect_line("led on", K_MSEC(IDLE_MS + SETTLE_MS));
+
+	/* the next bytes start a new line */
+	feed("count\r");
+	expect_line("count", K_MSEC(SETTLE_MS));
+}
+
+ZTEST(uart_async, test_full_buffer_idle)
+{
+	char text[RX_BUF_SIZE + 1];
+	size_t len = RX_BUF_SIZE - rx_fed % RX_BUF_SIZE;
+
+	/*
+	 * End the line exactly at the end of an RX buffer. The driver reports
+	 * the buffer as full and has nothing left to time out on, so only
+	 * the idle timer can end the line.
+	 */
+	for (size_t i = 0; i < len; i++) {
+		text[i] = 'a' + i % 26;
+	}
+	text[len] = '\0';
+
+	feed(text);
+	expect_line(text, K_MSEC(IDLE_MS + BUF_FILL_MS + SETTLE_MS));
+
+	feed("count\r");
+	expect_line("count", K_MSEC(SETTLE_MS));
+}
+
+static void *uart_async_setup(void)
+{
+	zassert_true(device_is_ready(uart), "emulated UART not ready");
+
+	line_ring_init(&rx_ring);
+	zassert_ok(uart_handler_init(&rx_ring));
+
+	return NULL;
+}
+
+static void uart_async_before(void *fixture)
+{
+	size_t len;
+	uint16_t tag;
+	char *line;
+
+	ARG_UNUSED(fixture);
+
+	/* let partial lines of a failed case end and drop them */
+	k_msleep(IDLE_MS + SETTLE_MS);
+	while ((line = line_ring_get(&rx_ring, &len, &tag, K_NO_WAIT)) != NULL) {
+		line_ring_release(&rx_ring, line);
+	}
+}
+
+ZTEST_SUITE(uart_async, NULL, uart_async_setup, uart_async_before, NULL, NULL);